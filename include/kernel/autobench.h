@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+// Headless benchmark runs, selected on the kernel command line:
+//
+//   autobench=ipc,sched iterations=2000
+//
+// The named suites (see kernel/bench.h) run at boot in place of the CLI,
+// bracketed by `@autobench-begin` / `@autobench-end status=<n>` lines on
+// serial, and the kernel then exits QEMU with that status (`make bench`).
+
+#define AUTOBENCH_DEFAULT_ITERATIONS 1000u
+
+typedef enum {
+    AUTOBENCH_OK = 0,
+    AUTOBENCH_SUITE_FAILED = 1,
+    AUTOBENCH_BAD_ARGS = 2,
+} autobench_status_t;
+
+// QEMU's isa-debug-exit device (-device isa-debug-exit,iobase=0xf4,iosize=0x04).
+// QEMU exits with (code << 1) | 1; without the device this returns.
+#define QEMU_DEBUG_EXIT_PORT 0xF4
+void qemu_debug_exit(uint8_t code);
+
+// 1 if the command line asks for an autobench run.
+int autobench_requested(void);
+
+// Run the requested suites; must be called from a task.
+autobench_status_t autobench_run(void);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+
+// Benchmark suites print one machine-readable line per case over serial
+// (and VGA), so runs can be collected and diffed across kernel versions:
+//
+//   @bench-begin suite=<name> version=<n> tsc_khz=<khz> source=<clock>
+//   @bench suite=<name> <case params> n=<samples> min=.. p50=.. p90=.. p99=.. max=.. mean=.. unit=<ns|cycles>
+//   @bench-end suite=<name>
+//
+// Keys are stable; new keys are only ever appended to a line. These lines are
+// never dropped by a full serial TX ring: each one waits for the ring to drain.
+
+#define BENCH_MAX_SAMPLES 4096u
+
+// Sample scratch space shared by the suites (only one runs at a time).
+extern uint32_t bench_samples[BENCH_MAX_SAMPLES];
+
+// One sample from two TSC readings, saturated to 32 bits.
+static inline uint32_t bench_delta(uint64_t end, uint64_t start) {
+    uint64_t d = end - start;
+    return d > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)d;
+}
+
+// Latency distribution of one case, in `unit` (nanoseconds or TSC cycles).
+typedef struct {
+    const char *unit;
+    uint32_t n;
+    uint64_t min;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t max;
+    uint64_t mean;
+} bench_summary_t;
+
+// Sort `n` per-operation TSC deltas in place and summarize them.
+void bench_summarize(uint32_t *cycles, uint32_t n, bench_summary_t *out);
+
+// Same, left in raw cycles (for costs well under the clock's resolution).
+void bench_summarize_cycles(uint32_t *cycles, uint32_t n, bench_summary_t *out);
+
+void bench_begin(const char *suite, uint32_t version);
+void bench_end(const char *suite);
+
+// `params` are the case's own key=value pairs, e.g. "case=payload size=32".
+void bench_report(const char *suite, const char *params, const bench_summary_t *s);
+
+// bench_report plus mb_s=<MB/s at the p50 latency> for a case moving `bytes`
+// per operation (s must be in cycles).
+void bench_report_bandwidth(const char *suite, const char *params, const bench_summary_t *s, uint32_t bytes);
+
+// IPC round-trip latency against the echo service: payload sizes, queue
+// depths (lock-step vs pipelined) and concurrent clients, n samples a case.
+// Suites return 0, or -1 if a case could not run.
+int bench_ipc(uint32_t n);
+
+// Scheduler costs in cycles: ctx_switch alone, task_yield through
+// scheduler_run, task_create/task_restart, and yield latency as runnable
+// tasks are added up to MAX_TASKS. n samples a case.
+int bench_sched(uint32_t n);
+
+// Per-operation cost of the console, echo and timer services. Lines carry
+// mode=microkernel or mode=monolithic so the two builds can be compared.
+int bench_ops(uint32_t n);
+
+// kmemcpy/kmemset/kmemcmp latency and bandwidth per size class, next to a
+// byte-at-a-time loop; copies are also run under each large-size strategy
+// the CPU supports. n samples a case.
+int bench_mem(uint32_t n);
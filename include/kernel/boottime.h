@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+#define BOOT_MAX_PHASES 24
+
+// One boot milestone: the TSC when it was reached. `name` must be static.
+typedef struct {
+    const char *name;
+    uint64_t tsc;
+} boot_phase_t;
+
+// Record that a phase ended now. Later marks (lazy service starts, the
+// first prompt) use the same timeline; extra marks past the limit are dropped.
+void boot_mark(const char *name);
+
+uint32_t boot_phase_count(void);
+const boot_phase_t *boot_phase_get(uint32_t index);
+
+// TSC of the first mark, or 0 before it.
+uint64_t boot_origin(void);
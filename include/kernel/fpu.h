@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// x87/SSE register state is switched lazily. A switch only sets CR0.TS when
+// the incoming task does not own the registers; its first FPU or SSE
+// instruction then traps (#NM), and the handler saves the previous owner's
+// FXSAVE image and loads the current task's. Tasks that never touch the FPU
+// never trap, and switching between them never writes CR0.
+//
+// Interrupt handlers must not use the FPU: they would run on the interrupted
+// task's registers.
+
+typedef struct {
+    int enabled;       // FXSR and SSE present and switched on
+    int owner;         // task whose state is in the registers, -1 = none,
+                       // MAX_TASKS = code outside any task
+    uint32_t traps;    // #NM exceptions taken
+    uint32_t saves;    // FXSAVEs of a previous owner
+    uint32_t restores; // FXRSTORs (first use loads the clean initial state)
+} fpu_stats_t;
+
+// Enable the FPU and SSE (CR0.MP/NE, CR4.OSFXSR/OSXMMEXCPT) and install the
+// #NM handler. Without FXSR and SSE the FPU stays disabled (CR0.EM).
+// Requires idt_init().
+void fpu_init(void);
+
+int fpu_sse_enabled(void);
+
+// Scheduler hook, called right before switching to task_id.
+void fpu_switch_to(int task_id);
+
+// Drop a task slot's saved state, for a new or restarted task.
+void fpu_task_reset(int task_id);
+
+void fpu_get_stats(fpu_stats_t *out);
@@ -0,0 +1,22 @@
+#pragma once
+
+// Segment selectors. The layout (kernel CS, kernel SS, user CS, user SS) is
+// the one SYSENTER/SYSEXIT derive from IA32_SYSENTER_CS.
+#define GDT_KERNEL_CODE 0x08
+#define GDT_KERNEL_DATA 0x10
+#define GDT_USER_CODE 0x1B
+#define GDT_USER_DATA 0x23
+#define GDT_TSS 0x28
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+// Load our own flat GDT (GRUB's is not guaranteed to survive) and the TSS.
+void gdt_init(void);
+
+// Stack the CPU switches to on a ring 3 -> ring 0 transition
+// (TSS.esp0 for interrupts, also used by the SYSENTER entry stub).
+void gdt_set_kernel_stack(uint32_t esp0);
+
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "kernel/ipc.h"
+
+#define GRANT_MAX 32
+#define GRANT_MAX_PAGES 16
+
+// Rights a grant carries; the receiver may map with any subset.
+#define GRANT_READ 0x1u
+#define GRANT_WRITE 0x2u
+
+typedef uint32_t grant_id_t;
+
+#define GRANT_INVALID ((grant_id_t)-1)
+
+// Payload of a message that hands a grant to another service
+// (e.g. MSG_LOG_BULK): the bytes [offset, offset + length) of the region.
+typedef struct {
+    grant_id_t id;
+    uint32_t offset;
+    uint32_t length;
+} grant_ref_t;
+
+// Payload of MSG_GRANT_DONE: the grant handed back, and 0 if the receiver
+// used it or -1 if it could not (bad reference, map failure).
+typedef struct {
+    grant_id_t id;
+    int32_t status;
+} grant_done_t;
+
+void grant_init(void);
+
+// Allocate `npages` zeroed pages the current task can fill and then grant.
+// Ring-0 tasks on the kernel space get identity-mapped pool pages; tasks with
+// their own space get them mapped into a private slot (user-accessible if
+// `user`). Buffers are meant to be allocated once and reused.
+void *grant_buffer_alloc(uint32_t npages, int user);
+
+// Share [addr, addr + npages pages) of the current address space with the
+// task that owns endpoint `target`. Returns GRANT_INVALID on failure.
+grant_id_t grant_create(const void *addr, uint32_t npages, endpoint_id_t target, uint32_t rights);
+
+// Map a grant into the current address space. `self` must be the grant's
+// target endpoint and `rights` a subset of the granted ones; the caller
+// vouches for `self` (the system call checks that ring 3 owns it). On a
+// private space the pages go into a free slot (user-accessible if `user`).
+// On the kernel space the identity address is returned: that mapping is
+// writable whatever `rights` say, so kernel-space callers are trusted to
+// honour a read-only grant. Returns 0 and sets *out.
+int grant_map(grant_id_t id, endpoint_id_t self, uint32_t rights, int user, void **out);
+
+// Size of the granted region in bytes (0 for an invalid grant).
+uint32_t grant_size(grant_id_t id);
+
+// Undo grant_map (receiver side). Map and unmap within one processing pass.
+int grant_unmap(grant_id_t id);
+
+// Owner withdraws the grant; any live receiver mapping is removed first.
+int grant_revoke(grant_id_t id);
+
+// Endpoint a grant was made for (ENDPOINT_INVALID for an invalid grant).
+endpoint_id_t grant_target(grant_id_t id);
+
+// The task in slot `task_id` is gone (finished, crashed, killed or about to
+// restart): revoke its grants and drop every mapping it made, so the slot's
+// next occupant, which inherits its page directory, sees none of them.
+void grant_release_task(int task_id);
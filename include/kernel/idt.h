@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+#define IDT_ENTRIES 256
+
+// CPU exception vectors used by the kernel.
+#define IDT_VEC_DIVIDE 0
+#define IDT_VEC_INVALID_OPCODE 6
+#define IDT_VEC_DEVICE_NA 7
+#define IDT_VEC_GP_FAULT 13
+#define IDT_VEC_PAGE_FAULT 14
+
+// Register snapshot pushed by the common ISR stub (see src/arch/i386/isr.S).
+typedef struct {
+    uint32_t edi, esi, ebp, esp_dummy, ebx, edx, ecx, eax;
+    uint32_t vector;
+    uint32_t error;
+    uint32_t eip, cs, eflags;
+    uint32_t user_esp, user_ss; // only pushed when the fault came from ring 3
+} interrupt_frame_t;
+
+typedef void (*interrupt_handler_t)(interrupt_frame_t *frame);
+
+// Load the IDT with stubs for the CPU exceptions (vectors 0-31) and the
+// remapped PIC lines (32-47, see kernel/irq.h).
+// Unhandled exceptions end up in panic(). Requires gdt_init().
+void idt_init(void);
+
+// Install a C handler for a vector that has an ISR stub.
+void idt_set_handler(uint8_t vector, interrupt_handler_t handler);
+
+// Point a vector at a raw entry stub with a DPL 3 gate (system calls).
+void idt_set_user_gate(uint8_t vector, uint32_t entry);
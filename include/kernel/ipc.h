@@ -22,6 +22,18 @@ typedef enum {
     MSG_TIMER_TICK, // Timer tick
     MSG_HEARTBEAT,  // Heartbeat for monitoring
     MSG_CRASH,      // Trigger service crash (for demo)
+    MSG_HANG,       // Make a service stop working but keep yielding (demo)
+    MSG_SYSCALL_BENCH, // Syscall path timing request/result (bench)
+    MSG_LOG_BULK,   // Log text in a granted region (payload: grant_ref_t)
+    MSG_GRANT_DONE, // Receiver finished with a grant (payload: grant_done_t)
+    MSG_SERVICE_REBOUND, // Registry binding changed (payload: service_rebound_t)
+    MSG_BLOCK_READ, // Read blocks into a grant (payload: block_req_t)
+    MSG_BLOCK_WRITE, // Write blocks from a grant (payload: block_req_t)
+    MSG_BLOCK_REPLY, // Block request done (payload: block_reply_t)
+    MSG_FS_OPEN,    // Look up a file (payload: path)
+    MSG_FS_STAT,    // File size and mode (payload: path)
+    MSG_FS_READ,    // Borrow file bytes by grant (payload: fs_read_req_t)
+    MSG_FS_REPLY,   // File request done (payload: fs_reply_t)
     MSG_MAX
 } msg_type_t;
 
@@ -48,6 +60,29 @@ void ipc_init(void);
 // Allocate a new endpoint
 endpoint_id_t ipc_endpoint_create(void);
 
+// Release an endpoint; queued messages are discarded and the id may be reused.
+void ipc_endpoint_destroy(endpoint_id_t ep);
+
+// Ring 3 may only receive on, and name as a sender, endpoints owned by its
+// task. Endpoints start kernel-only (owner -1); the kernel assigns them when it
+// starts a ring-3 task.
+void ipc_endpoint_set_owner(endpoint_id_t ep, int task_id);
+int ipc_endpoint_owned_by(endpoint_id_t ep, int task_id);
+
+// Drop every endpoint owned by task_id (its slot is being reused).
+void ipc_endpoint_disown(int task_id);
+
+// Called by the first ipc_send to an endpoint, before the message is queued
+// (lazy service start). One-shot; NULL removes a pending hook.
+typedef void (*ipc_send_hook_t)(endpoint_id_t ep);
+void ipc_set_send_hook(endpoint_id_t ep, ipc_send_hook_t hook);
+
+// Monolithic build (MODE=monolithic): a send to an endpoint with a direct
+// handler calls it in the sender's context instead of queueing the message.
+// Runs after any send hook; NULL removes the handler.
+typedef void (*ipc_direct_handler_t)(endpoint_id_t ep, const ipc_msg_t *msg);
+void ipc_set_direct_handler(endpoint_id_t ep, ipc_direct_handler_t handler);
+
 // Send a message to an endpoint (non-blocking)
 ipc_error_t ipc_send(endpoint_id_t dst, const ipc_msg_t *msg);
 
@@ -56,3 +91,6 @@ ipc_error_t ipc_recv(endpoint_id_t src, ipc_msg_t *out_msg);
 
 // Check if endpoint has pending messages
 int ipc_has_messages(endpoint_id_t ep);
+
+// Number of queued messages (0 for invalid endpoints)
+uint32_t ipc_queue_depth(endpoint_id_t ep);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "kernel/idt.h"
+
+// Legacy PIC lines are remapped to vectors IRQ_VECTOR_BASE..+15.
+#define IRQ_VECTOR_BASE 32
+#define IRQ_COUNT 16
+
+#define IRQ_TIMER 0
+#define IRQ_COM1 4
+
+// Remap both 8259 PICs away from the CPU exception vectors and mask every line.
+void irq_init(void);
+
+// Install a handler for an IRQ line and unmask it. The handler runs with
+// interrupts disabled; EOI is sent after it returns.
+void irq_set_handler(uint8_t irq, interrupt_handler_t handler);
+
+void irq_mask(uint8_t irq);
+void irq_unmask(uint8_t irq);
+
+// Save IF and disable interrupts / restore the saved IF.
+static inline uint32_t irq_save(void) {
+    uint32_t flags;
+    __asm__ volatile("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void irq_restore(uint32_t flags) {
+    if (flags & 0x200u) {
+        __asm__ volatile("sti" : : : "memory");
+    }
+}
+
+static inline int irq_enabled(void) {
+    uint32_t flags;
+    __asm__ volatile("pushfl; popl %0" : "=r"(flags));
+    return (flags & 0x200u) != 0;
+}
@@ -3,6 +3,10 @@
 
 #include <stdint.h>
 
+// PgUp/PgDn arrive as these control characters.
+#define KBD_KEY_PAGE_UP 0x11
+#define KBD_KEY_PAGE_DOWN 0x12
+
 void keyboard_init(void);
 int keyboard_read_nonblocking(char *out);
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Deferred binary logging: callers record a format string pointer, a severity
+// and up to KLOG_MAX_ARGS raw 32-bit arguments into their task's ring; the
+// console service formats and prints records later.
+//
+// The format must be a string literal, and "%s" arguments must point at
+// strings that outlive the record (names, literals). Records are rendered with
+// ksnprintf, so any 32-bit conversion works (no %ll). Not callable from IRQ
+// handlers.
+
+typedef enum {
+    KLOG_DEBUG = 0,
+    KLOG_INFO = 1,
+    KLOG_WARN = 2,
+    KLOG_ERROR = 3,
+} klog_level_t;
+
+#define KLOG_MAX_ARGS 4
+#define KLOG_RING_ENTRIES 32u // per task, power of two
+
+typedef struct {
+    const char *fmt;
+    uint32_t seq; // global order across rings
+    uint8_t level;
+    uint8_t nargs;
+    int16_t task; // -1 outside any task
+    uint32_t args[KLOG_MAX_ARGS];
+} klog_record_t;
+
+#define KLOG_COUNT_(fmt, a, b, c, d, n, ...) n
+#define KLOG_COUNT(...) KLOG_COUNT_(__VA_ARGS__, 4, 3, 2, 1, 0, _)
+
+// klog(KLOG_INFO, "echo: %u requests", n);
+#define klog(level, ...) klog_write((level), KLOG_COUNT(__VA_ARGS__), __VA_ARGS__)
+
+void klog_init(void);
+void klog_write(klog_level_t level, uint32_t nargs, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+// Records below this level are discarded at the call site (default KLOG_INFO).
+void klog_set_level(klog_level_t level);
+
+// Consumer side (console service): oldest record across all rings.
+// Returns 1 and fills *out, or 0 when every ring is empty.
+int klog_pop(klog_record_t *out);
+uint32_t klog_pending(void);
+
+// Render "[LEVEL] message\n" into buf; returns the length (truncated to size).
+size_t klog_format(const klog_record_t *rec, char *buf, size_t size);
+
+typedef struct {
+    uint32_t written;
+    uint32_t dropped; // ring full at the call site
+    uint32_t shed;    // discarded by the console under load
+} klog_stats_t;
+
+void klog_get_stats(klog_stats_t *out);
+void klog_note_shed(void);
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Kernel memcpy/memset/memcmp. Each call picks a path by size: short copies
+// use unrolled dword moves, larger ones `rep movsd`/`rep stosd`, or `rep movsb`
+// (ERMS) or SSE2 once kmem_init has found them. Compares check 16 bytes per
+// branch, and 64-byte blocks with SSE2 on large sizes. Before kmem_init, and in host
+// builds, only the portable paths are used. Regions must not overlap.
+//
+// These are kernel-only: code built into the user image must not call them.
+
+// Strategy for copies and fills past the unrolled range.
+typedef enum {
+    KMEM_IMPL_REP = 0, // rep movsd / rep stosd
+    KMEM_IMPL_ERMS,    // rep movsb / rep stosb (fast strings)
+    KMEM_IMPL_SSE2,    // 16-byte aligned SSE2 stores
+    KMEM_IMPL_COUNT
+} kmem_impl_t;
+
+void *kmemcpy(void *dst, const void *src, size_t n);
+void *kmemset(void *dst, int c, size_t n);
+int kmemcmp(const void *a, const void *b, size_t n);
+
+// Fill `count` 16-bit (VGA cells) or 32-bit (stack canaries) words.
+void kmemset16(void *dst, uint16_t value, size_t count);
+void kmemset32(void *dst, uint32_t value, size_t count);
+
+// CPUID probe: picks the fastest large-size strategy. SSE2 needs fpu_init()
+// to have enabled SSE first. Call once at boot, before any task runs.
+void kmem_init(void);
+
+kmem_impl_t kmem_impl(void);
+const char *kmem_impl_name(kmem_impl_t impl);
+
+// Path a byte copy or fill (cmp = 0) or a compare (cmp = 1) of n bytes takes
+// under the current strategy: "unrolled", "rep", "erms" or "sse2". Short
+// sizes always run unrolled, whatever kmem_impl() says.
+const char *kmem_path_name(size_t n, int cmp);
+int kmem_impl_supported(kmem_impl_t impl);
+
+// Force a strategy (for benchmarks). Returns -1 if the CPU lacks it.
+int kmem_set_impl(kmem_impl_t impl);
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+
+// Freestanding printf subset:
+//   %d %i %u %x %X %c %s %p %%, with the l (32-bit) and ll (64-bit)
+//   length modifiers, '-' and '0' flags, and a field width (digits or '*').
+// Returns the length the full output would have, like snprintf; the buffer is
+// always NUL-terminated when size > 0.
+int kvsnprintf(char *buf, size_t size, const char *fmt, va_list ap);
+int ksnprintf(char *buf, size_t size, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+// Format into a stack buffer (KPRINTF_BUF_SIZE bytes; longer output is cut)
+// and write it to the serial port and the VGA console.
+#define KPRINTF_BUF_SIZE 256
+int kprintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
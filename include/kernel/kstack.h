@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Variable-size allocator for task stacks, carved from one static arena.
+// Stacks sit back to back, so each one has a guard band of known words just
+// below it: an overflow lands there before it reaches the neighbour.
+#define KSTACK_ARENA_SIZE (48u * 1024u)
+#define KSTACK_ALIGN 16u
+#define KSTACK_GUARD_SIZE 512u
+
+void kstack_init(void);
+
+// Returns a KSTACK_ALIGN-aligned block of at least `size` bytes, or NULL.
+void *kstack_alloc(uint32_t size);
+
+void kstack_free(void *stack);
+
+// Repaint the guard band below a stack (e.g. when its task restarts), and
+// check every word of it. Returns 1 while no overflow has touched it.
+void kstack_guard_reset(void *stack);
+int kstack_guard_intact(const void *stack);
+
+// Arena usage in bytes.
+void kstack_stats(uint32_t *used, uint32_t *free_bytes, uint32_t *largest_free);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+
+// Value the loader leaves in EAX for a Multiboot2 boot.
+#define MULTIBOOT2_BOOTLOADER_MAGIC 0x36D76289u
+
+#define MB2_MAX_MODULES 4
+#define MB2_CMDLINE_MAX 128
+#define MB2_MODULE_NAME_MAX 32
+
+// A boot module (`module2` in grub.cfg): physical range and its command line.
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    char cmdline[MB2_MODULE_NAME_MAX];
+} mb2_module_t;
+
+// Copy what the kernel needs out of the boot information. Call first, while
+// paging is still off; later calls find everything in kernel memory.
+void multiboot2_init(uint32_t magic, uint32_t info_addr);
+
+// 1 if the kernel was started by a Multiboot2 loader.
+int multiboot2_present(void);
+
+// Kernel command line ("" if none).
+const char *multiboot2_cmdline(void);
+
+// Value of `key` on the kernel command line: the text after "key=" (up to
+// the next space), "" for a bare "key", NULL if absent.
+const char *multiboot2_cmdline_get(const char *key);
+
+uint32_t multiboot2_module_count(void);
+const mb2_module_t *multiboot2_module(uint32_t index);
+
+// First module whose command line starts with the word `name`, or NULL.
+const mb2_module_t *multiboot2_find_module(const char *name);
+
+// Identity-map every module in the kernel space. Must run after paging_init
+// and before the first address space is created. Returns -1 if one failed.
+int multiboot2_map_modules(void);
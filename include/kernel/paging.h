@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+
+#define PAGE_SIZE 4096u
+#define PAGE_LARGE_SIZE 0x400000u
+
+// Page directory / page table entry bits.
+#define PG_PRESENT 0x001u
+#define PG_WRITE 0x002u
+#define PG_USER 0x004u
+#define PG_LARGE 0x080u
+#define PG_GLOBAL 0x100u
+
+// The kernel image (text, data, bss, stacks, page pool) lives in the first
+// 4 MB and is identity-mapped with one global PSE page in every address space.
+#define PAGING_KERNEL_MAP_BYTES PAGE_LARGE_SIZE
+
+// Per-space private window: backed by a 4 KB page table that is unique to
+// each address space, so the same virtual range maps different frames.
+#define PAGING_PRIVATE_BASE 0x40000000u
+#define PAGING_PRIVATE_SIZE PAGE_LARGE_SIZE
+
+// Ring-3 layout inside the private window: the user image (src/user/,
+// linked at PAGING_PRIVATE_BASE by linker.ld) at the bottom, the user stack
+// at the top.
+#define PAGING_USER_STACK_PAGES 2u
+#define PAGING_USER_STACK_TOP (PAGING_PRIVATE_BASE + PAGING_PRIVATE_SIZE)
+
+// Slot area in the private window for shared buffers and mapped grants:
+// PAGING_SLOT_COUNT slots of PAGING_SLOT_PAGES pages each.
+#define PAGING_SLOT_BASE (PAGING_PRIVATE_BASE + 0x100000u)
+#define PAGING_SLOT_PAGES 16u
+#define PAGING_SLOT_COUNT 16u
+
+#define PAGING_MAX_SPACES 10
+
+// Address spaces are identified by their CR3 value (physical address of the
+// page directory). 0 is never a valid space.
+typedef uint32_t addr_space_t;
+
+// Build the kernel page directory, enable PSE/PGE and turn paging on.
+void paging_init(void);
+
+// The boot/kernel address space (used by the scheduler and ring-0 tasks).
+addr_space_t paging_kernel_space(void);
+
+// Identity-map [paddr, paddr + len) in the kernel space with supervisor 4 MB
+// pages (boot modules above the kernel image). Spaces copy the kernel
+// directory when created, so this only works before the first one exists.
+// Returns 0 on success, -1 if spaces exist or the range hits the private window.
+int paging_map_identity(uint32_t paddr, uint32_t len);
+
+// 1 if [paddr, paddr + len) is identity-mapped in every space (the kernel
+// image, or a range added with paging_map_identity).
+int paging_is_identity(uint32_t paddr, uint32_t len);
+
+// Create a new address space sharing the kernel mapping.
+// Returns 0 if the pool is exhausted.
+addr_space_t paging_space_create(void);
+
+// Map one 4 KB page inside the private window of a space.
+// Returns 0 on success, -1 on bad arguments or pool exhaustion.
+int paging_map_private(addr_space_t space, uint32_t vaddr, uint32_t paddr, uint32_t flags);
+
+// Remove one private-window mapping (and flush it if `space` is live).
+void paging_unmap_private(addr_space_t space, uint32_t vaddr);
+
+// Reserve / release one slot (PAGING_SLOT_PAGES pages of virtual space).
+// Returns the slot's base address, or 0 if none is free.
+uint32_t paging_slot_alloc(addr_space_t space);
+void paging_slot_free(addr_space_t space, uint32_t vaddr);
+
+// Translate a virtual address of `space`. The kernel region translates to
+// itself. Returns 0 and fills *paddr / *flags (PG_* bits), or -1 if unmapped.
+int paging_translate(addr_space_t space, uint32_t vaddr, uint32_t *paddr, uint32_t *flags);
+
+// Map the user image (read-only) and a user stack into a space, once.
+// Returns 0 on success (or if already done), -1 on pool exhaustion.
+int paging_space_setup_user(addr_space_t space);
+
+// 1 if [vaddr, vaddr+len) lies in the private window of `space` and every page
+// is present and user-accessible (and writable, if `write`).
+int paging_user_range_ok(addr_space_t space, uint32_t vaddr, uint32_t len, int write);
+
+// Allocate one zeroed 4 KB frame from the kernel page pool.
+// Frames are identity-mapped, so the returned pointer is also the physical address.
+void *paging_alloc_frame(void);
+
+// Allocate `count` physically (and so virtually) contiguous zeroed frames.
+void *paging_alloc_frames(uint32_t count);
+
+// Give back a block from paging_alloc_frames, to undo a failed setup. The pool
+// is a bump allocator: only the newest block can return, older ones stay used.
+void paging_free_frames(void *frames, uint32_t count);
+
+// Page pool usage in 4 KB frames.
+void paging_pool_stats(uint32_t *used, uint32_t *total);
+
+// When disabled, every ring-0 task runs on the kernel space and ctx_switch
+// never reloads CR3 for them (ring-3 tasks always need their own space).
+// Used by `bench` to measure the cost of isolation.
+void paging_set_isolation(int enabled);
+int paging_isolation_enabled(void);
+
+static inline uint32_t paging_read_cr3(void) {
+    uint32_t v;
+    __asm__ volatile("mov %%cr3, %0" : "=r"(v));
+    return v;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// Sampling profiler: PIT channel 0 ticks IRQ0 at PROF_TIMER_HZ while it runs,
+// and every Nth tick records the interrupted EIP, the current task and (for
+// ring 0, via the EBP chain) a few return addresses into a fixed ring.
+// The oldest samples are overwritten once the ring is full.
+
+#define PROF_TIMER_HZ 1000u
+#define PROF_RING_SIZE 2048u
+#define PROF_MAX_DEPTH 6u
+
+typedef struct {
+    int running;
+    uint32_t every;       // sample every Nth tick
+    uint32_t ticks;
+    uint32_t samples;     // held in the ring
+    uint32_t overwritten; // lost to ring wrap-around
+} prof_stats_t;
+
+// Clear the ring and start sampling (every 0 is taken as 1). Needs irq_init().
+void prof_start(uint32_t every);
+void prof_stop(void);
+void prof_get_stats(prof_stats_t *out);
+
+// Stop sampling and write the ring to serial only, oldest first, for
+// scripts/prof_symbolize.py:
+//
+//   @prof-begin hz=<hz> every=<n> samples=<n> overwritten=<n>
+//   @prof-task id=<id> name=<name>
+//   @prof task=<id> ring=<0|3> pc=<hex> stack=<hex>,<hex>,...
+//   @prof-end
+//
+// task=-1 is the scheduler loop; stack lists callers, innermost first.
+void prof_dump(void);
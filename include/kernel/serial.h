@@ -1,8 +1,32 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
+#define SERIAL_TX_RING_SIZE 4096u
+#define SERIAL_TX_RING_MASK (SERIAL_TX_RING_SIZE - 1u)
+
 void serial_init(void);
 void serial_write(const char *s);
 
+// Writes fill the 16550 transmit FIFO (16 bytes) per "transmit empty" poll
+// or interrupt. Disabling falls back to one byte each; used by `bench log`.
+void serial_set_fifo_burst(int enabled);
+
+// Switch between polled output and the IRQ4-driven transmit ring (needs
+// irq_init()). Writers with interrupts enabled never wait: bytes that do not
+// fit in the ring are dropped and counted. With interrupts off, a full ring
+// is drained by polling instead, so early boot and fault paths lose nothing.
+void serial_set_async(int enabled);
+
+// Drain the transmit ring by polling. Call before halting or dumping state.
+void serial_flush(void);
+
+void serial_tx_stats(uint32_t *queued, uint32_t *dropped);
+
+// Write exactly len bytes (no NUL needed), with the same '\n' -> "\r\n" mapping.
+void serial_write_len(const char *s, size_t len);
+
 // Blocks until a character is available on COM1.
 char serial_read_blocking(void);
 
@@ -3,23 +3,85 @@
 #include "kernel/ipc.h"
 
 #define SERVICE_MAX_NAME_LEN 32
-#define SERVICE_MAX_ENTRIES 16
+#define SERVICE_MAX_ENTRIES 16      // distinct names
+#define SERVICE_MAX_INSTANCES 4     // endpoints per name (replicas)
+#define SERVICE_MAX_SUBSCRIBERS 4
 
-// Service registry entry
+// Names are interned in an open-addressed hash table and never move, so a
+// handle (table slot + binding version) resolves in O(1) with no string
+// compare. The version changes whenever an endpoint is bound to or removed
+// from the name; a cached handle still resolves, and reports the change.
+typedef uint32_t service_handle_t;
+#define SERVICE_HANDLE_INVALID ((service_handle_t)0xFFFFFFFFu)
+#define SERVICE_HANDLE_SLOT(h) ((h) & 0xFFFFu)
+#define SERVICE_HANDLE_VERSION(h) ((h) >> 16)
+
+// Payload of MSG_SERVICE_REBOUND, sent to registry subscribers on every change.
 typedef struct {
-    char name[SERVICE_MAX_NAME_LEN];
-    endpoint_id_t endpoint;
-    int active;
-} service_entry_t;
+    service_handle_t handle; // with the new version
+    uint32_t instances;
+} service_rebound_t;
+
+// How a lookup picks among several instances registered under one name.
+typedef enum {
+    SERVICE_BALANCE_ROUND_ROBIN,
+    SERVICE_BALANCE_LEAST_QUEUE, // shortest IPC queue, round-robin on ties (default)
+} service_balance_t;
 
 // Initialize service registry
 void service_registry_init(void);
 
-// Register a service
+// FNV-1a hash used to key the table. A caller that names a service
+// repeatedly can hash it once and pass it to the *_hashed variants, which
+// skip hashing; `hash` must be service_name_hash(name).
+uint32_t service_name_hash(const char *name);
+
+// Register a service. Registering more endpoints under the same name adds
+// instances (replicas); lookups are spread across them.
 int service_register(const char *name, endpoint_id_t endpoint);
+int service_register_hashed(const char *name, uint32_t hash, endpoint_id_t endpoint);
+
+// Remove one instance. Returns 0, or -1 if it was not registered.
+int service_unregister(const char *name, endpoint_id_t endpoint);
 
-// Lookup a service by name
+// Lookup a service by name (one of its instances, see service_set_balance)
 endpoint_id_t service_lookup(const char *name);
+endpoint_id_t service_lookup_hashed(const char *name, uint32_t hash);
+
+// Resolve a name once; returns SERVICE_HANDLE_INVALID for unknown names.
+service_handle_t service_resolve(const char *name);
+service_handle_t service_resolve_hashed(const char *name, uint32_t hash);
+
+// Pick an instance through a cached handle (resolving *h on first use when it
+// is SERVICE_HANDLE_INVALID and name is given). If the binding changed since
+// the handle was taken, *h is updated and *rebound (if not NULL) set to 1.
+endpoint_id_t service_handle_lookup(service_handle_t *h, const char *name, int *rebound);
+
+const char *service_handle_name(service_handle_t h);
+
+// Instance count and total queue depth through a handle: no hashing or
+// string compare, for callers that poll a name (e.g. the autoscaler).
+int service_handle_instances(service_handle_t h);
+uint32_t service_handle_queue_depth(service_handle_t h);
+
+int service_instance_count(const char *name);
+
+// Messages queued across all instances of a name
+uint32_t service_queue_depth(const char *name);
+
+void service_set_balance(service_balance_t policy);
+
+// Lazy services: registered at boot, but their task is only started by the
+// first lookup of the name or the first message to one of its endpoints.
+// `start` runs once, in the context of that caller; returns 0 on success.
+typedef int (*service_start_fn_t)(void);
+int service_set_lazy(const char *name, service_start_fn_t start);
+
+// 1 while a lazy service has not been started yet.
+int service_is_pending(const char *name);
+
+// Registry topic: ep receives MSG_SERVICE_REBOUND for every name change.
+int service_subscribe(endpoint_id_t ep);
 
 // List all registered services (for debugging)
 void service_list_all(void);
@@ -0,0 +1,54 @@
+#pragma once
+
+// System-call ABI shared by the kernel and ring-3 code.
+//
+// In:  EAX = number, EBX = a0, ESI = a1, EDI = a2.
+// Out: EAX = result, EBX/ESI/EDI = extra results (see SYS_IPC_RECV).
+// The SYSENTER stub also uses EBP to carry the user ESP, and ECX/EDX are
+// clobbered by SYSEXIT, so only EBX/ESI/EDI carry arguments on both paths.
+#define SYSCALL_INT_VECTOR 0x80
+
+#define SYS_NULL 0          // does nothing; for measuring entry/exit cost
+#define SYS_YIELD 1
+#define SYS_EXIT 2
+#define SYS_IPC_SEND 3      // a0 = dst, a1 = user pointer to ipc_msg_t
+#define SYS_IPC_SEND_SHORT 4 // a0 = packed header, a1/a2 = payload bytes 0-7
+#define SYS_IPC_RECV 5      // a0 = endpoint, a1 = user buffer (filled only for long payloads)
+#define SYS_BUFFER_ALLOC 6   // a0 = pages; returns user address or 0
+#define SYS_GRANT_CREATE 7   // a0 = addr, a1 = pages | rights << 16, a2 = target endpoint
+#define SYS_GRANT_MAP 8      // a0 = grant, a1 = own endpoint, a2 = rights; EBX = address
+#define SYS_GRANT_UNMAP 9    // a0 = grant
+#define SYS_GRANT_REVOKE 10  // a0 = grant
+#define SYS_MAX 11
+
+// Short messages carry up to 8 payload bytes in ESI:EDI and this header in EBX.
+// Endpoint 0xFF in a header stands for ENDPOINT_INVALID.
+#define SYSCALL_SHORT_MAX 8u
+#define SYSCALL_HDR_PACK(ep, sender, type, len) \
+    (((uint32_t)(ep) & 0xFFu) | (((uint32_t)(sender) & 0xFFu) << 8) | \
+     (((uint32_t)(type) & 0xFFu) << 16) | (((uint32_t)(len) & 0xFFu) << 24))
+#define SYSCALL_HDR_EP(h) ((h) & 0xFFu)
+#define SYSCALL_HDR_SENDER(h) (((h) >> 8) & 0xFFu)
+#define SYSCALL_HDR_TYPE(h) (((h) >> 16) & 0xFFu)
+#define SYSCALL_HDR_LEN(h) (((h) >> 24) & 0xFFu)
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+// Registers as saved by both entry stubs (src/arch/i386/syscall_entry.S).
+typedef struct {
+    uint32_t eax;
+    uint32_t ebx;
+    uint32_t esi;
+    uint32_t edi;
+    uint32_t user_esp;
+} syscall_regs_t;
+
+// Program the SYSENTER MSRs (when the CPU has SEP) and the int 0x80 gate.
+void syscall_init(void);
+
+// 1 if SYSENTER/SYSEXIT are usable, so ring-3 services can be started.
+int syscall_fast_path_available(void);
+
+#endif
@@ -2,14 +2,46 @@
 
 #include <stdint.h>
 
+#define MAX_TASKS 10
+
+// Stack sizes a task may request (bytes); 0 in task_attr_t means the default.
+#define TASK_STACK_DEFAULT 4096u
+#define TASK_STACK_MIN 1024u
+#define TASK_STACK_MAX 16384u
+
 typedef void (*task_entry_t)(void *arg);
 
+// Give the task its own page directory (see kernel/paging.h).
+#define TASK_FLAG_ISOLATED 0x1u
+// Run the entry point in ring 3 (implies TASK_FLAG_ISOLATED). The entry must
+// live in the user image (src/user/); see user/user_tasks.h.
+#define TASK_FLAG_USER 0x2u
+
+// Optional creation attributes for task_create_ex.
+typedef struct {
+    uint32_t flags;      // TASK_FLAG_*
+    uint32_t stack_size; // kernel stack bytes, 0 = TASK_STACK_DEFAULT
+} task_attr_t;
+
+// Snapshot of one task slot for diagnostics (`mem`).
+typedef struct {
+    const char *name;
+    int running;          // runnable (not finished / unused)
+    uint32_t stack_size;
+    uint32_t stack_peak;  // high-water mark since the last (re)start, in bytes
+    int stack_overflow;   // bottom canary was found clobbered
+    uint32_t runs;        // times the scheduler has switched to it
+} task_info_t;
+
 void task_init(void);
 
 // Creates a runnable task with its own stack.
 // Returns task id on success, -1 on failure.
 int task_create(const char *name, task_entry_t entry, void *arg);
 
+// Same as task_create, with attributes (attr may be NULL).
+int task_create_ex(const char *name, task_entry_t entry, void *arg, const task_attr_t *attr);
+
 // Cooperative yield: switches back to the scheduler.
 void task_yield(void);
 
@@ -19,9 +51,37 @@ void scheduler_run(void);
 // Get current task ID (-1 if not in a task)
 int task_get_current(void);
 
-// Restart a crashed task with the same entry point
+// Changes each time the slot starts a task (create or restart), so state keyed
+// on a task id can tell the current occupant from an earlier one. 0 outside a task.
+uint32_t task_get_generation(int task_id);
+
+// Times the scheduler has switched to the task (cheap, unlike task_get_info)
+uint32_t task_get_runs(int task_id);
+
+// Restart a crashed (held by the fault hook) or hung task with the same entry
+// point. Fails on a slot that is free, since it may now belong to another task.
 int task_restart(int task_id);
 
+// Stop a runnable task for good (it cannot be restarted), or release a held
+// crash so the slot can be reused. The task is not unwound: only kill tasks
+// that hold nothing across task_yield.
+int task_kill(int task_id);
+
 // Mark the current task as finished and yield back to the scheduler.
 // Safe to call only from within a running task.
 void task_exit_current(void);
+
+// Fill *out for a task slot. Scans the stack for the canary high-water mark.
+// Returns 0, or -1 if the slot never held a task.
+int task_get_info(int task_id, task_info_t *out);
+
+// Schedule task_id right after the current task yields (one-shot hint), e.g.
+// to let a supervisor react to a fault without waiting for its turn.
+void task_run_next(int task_id);
+
+// Called (in the dying task's context) when a task is killed by panic() or a
+// CPU exception, so a supervisor can schedule a restart. Returning nonzero
+// claims the task: its slot is held until task_restart or task_kill.
+typedef int (*task_fault_hook_t)(int task_id);
+void task_set_fault_hook(task_fault_hook_t hook);
+void task_report_fault(int task_id);
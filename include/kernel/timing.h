@@ -14,9 +14,63 @@ static inline tsc_t tsc_now(void) {
     return t;
 }
 
+static inline uint64_t tsc_to_u64(tsc_t t) {
+    return ((uint64_t)t.hi << 32) | t.lo;
+}
+
 static inline tsc_t tsc_sub(tsc_t end, tsc_t start) {
     tsc_t d;
     d.lo = end.lo - start.lo;
     d.hi = end.hi - start.hi - (end.lo < start.lo ? 1u : 0u);
     return d;
 }
+
+static inline uint64_t tsc_read(void) {
+    return tsc_to_u64(tsc_now());
+}
+
+// Serialized reads for benchmarks: bench_start keeps earlier work from
+// leaking into the interval, bench_stop waits for the measured work to
+// retire (RDTSCP, else LFENCE; CPUID when neither is available).
+#define TSC_CAP_LFENCE    0x1u
+#define TSC_CAP_RDTSCP    0x2u
+#define TSC_CAP_INVARIANT 0x4u
+extern uint32_t tsc_caps;
+
+static inline void tsc_serialize(void) {
+    if (tsc_caps & TSC_CAP_LFENCE) {
+        __asm__ volatile("lfence" ::: "memory");
+    } else {
+        uint32_t a = 0, b, c, d;
+        __asm__ volatile("cpuid" : "+a"(a), "=b"(b), "=c"(c), "=d"(d) :: "memory");
+    }
+}
+
+static inline tsc_t tsc_bench_start(void) {
+    tsc_serialize();
+    tsc_t t = tsc_now();
+    tsc_serialize();
+    return t;
+}
+
+static inline tsc_t tsc_bench_stop(void) {
+    tsc_t t;
+    if (tsc_caps & TSC_CAP_RDTSCP) {
+        uint32_t aux;
+        __asm__ volatile("rdtscp" : "=a"(t.lo), "=d"(t.hi), "=c"(aux) :: "memory");
+    } else {
+        tsc_serialize();
+        t = tsc_now();
+    }
+    tsc_serialize();
+    return t;
+}
+
+// Calibrated clock (kernel only). clock_init measures the TSC rate once at
+// boot: CPUID leaf 0x15 when it reports the crystal, else PIT channel 2.
+// Cycles become ns as (cycles * mult) >> shift, with mult fitting 32 bits.
+void clock_init(void);
+uint32_t clock_tsc_khz(void);
+const char *clock_source(void);
+uint64_t clock_cycles_to_ns(uint64_t cycles);
+uint64_t clock_monotonic_ns(void);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+// Static tracepoints. Each site costs one load and branch while tracing is
+// off; when on, a record (TSC, CPU, task, two args) goes into a fixed ring
+// that overwrites its oldest records. One CPU, so one ring.
+
+#define TRACE_RING_SIZE 4096u
+
+typedef enum {
+    TRACE_NONE = 0,
+    TRACE_SWITCH_IN,    // scheduler -> task; a0 = task id, a1 = runs
+    TRACE_SWITCH_OUT,   // task -> scheduler; a0 = task id, a1 = 1 if it finished
+    TRACE_IPC_SEND,     // a0 = destination endpoint, a1 = message type
+    TRACE_IPC_RECV,     // a0 = source endpoint, a1 = message type
+    TRACE_TASK_RESTART, // a0 = task id
+    TRACE_CRASH,        // a0 = endpoint reported to the monitor
+    TRACE_SVC_DISPATCH, // service picked up a message; a0 = endpoint, a1 = type
+    TRACE_EVENT_MAX
+} trace_event_t;
+
+typedef struct {
+    uint64_t tsc;
+    uint16_t event; // trace_event_t
+    uint8_t cpu;
+    int8_t task;    // -1 = scheduler
+    uint32_t a0;
+    uint32_t a1;
+} trace_record_t;
+
+extern int trace_enabled;
+
+void trace_record(trace_event_t ev, uint32_t a0, uint32_t a1);
+
+static inline void trace(trace_event_t ev, uint32_t a0, uint32_t a1) {
+    if (trace_enabled) {
+        trace_record(ev, a0, a1);
+    }
+}
+
+void trace_set_enabled(int enabled);
+void trace_clear(void);
+void trace_get_stats(uint32_t *records, uint32_t *overwritten);
+const char *trace_event_name(trace_event_t ev);
+
+// Stop tracing and write the ring to serial only, oldest first, for
+// scripts/trace2chrome.py:
+//
+//   @trace-begin tsc_khz=<khz> records=<n> overwritten=<n>
+//   @trace-task id=<id> name=<name>
+//   @trace t=<tsc> cpu=<n> task=<id> ev=<name> a0=<n> a1=<n>
+//   @trace-end
+void trace_dump(void);
@@ -12,8 +12,15 @@ size_t uint_to_str(uint32_t value, char *buf, size_t buf_size);
 // Returns the length (8) on success, 0 on failure.
 size_t u32_to_hex(uint32_t value, char *buf, size_t buf_size);
 
+// 64-by-32-bit division without libgcc (two DIV instructions).
+// Returns the quotient; stores the remainder in *rem when rem is not NULL.
+uint64_t u64_div_u32(uint64_t n, uint32_t d, uint32_t *rem);
+
 // Safe string length
 size_t str_len(const char *s);
 
+// FNV-1a hash of a string (NULL hashes like "")
+uint32_t str_hash(const char *s);
+
 // Safe string copy with bounds checking
 void str_copy_safe(char *dst, const char *src, size_t dst_size);
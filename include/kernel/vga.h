@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 typedef enum {
@@ -21,9 +22,22 @@ typedef enum {
     VGA_COLOR_WHITE = 15,
 } vga_color_t;
 
+#define VGA_WIDTH 80
+#define VGA_HEIGHT 25
+#define VGA_SCROLLBACK_PAGES 8 // screens of history kept in RAM, live one included
+
 void vga_init(void);
 void vga_set_color(vga_color_t fg, vga_color_t bg);
 void vga_puts(const char *s);
+void vga_write(const char *s, size_t len);
 void vga_putc(char c);
 
+// Output lands in a RAM shadow; each public write call ends with one flush of
+// the rows it changed. Scrolling moves a ring index instead of copying cells.
+void vga_flush(void);
+
+// Move the view back (rows > 0) or forward (rows < 0) through the history.
+// Any new output returns to the live screen.
+void vga_scrollback(int rows);
+
 void vga_clear(void);
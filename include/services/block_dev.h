@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+#define BLOCK_SIZE 512u
+
+typedef struct block_dev block_dev_t;
+
+// Backend operations, in whole blocks. A backend may serve any run length;
+// the block service hands it the longest runs it can (batched misses and
+// read-ahead), so a device with per-command cost (ATA, virtio) benefits.
+// Both return 0 on success, -1 on an out-of-range or failed transfer.
+typedef struct {
+    int (*read)(block_dev_t *dev, uint32_t lba, uint32_t count, void *buf);
+    int (*write)(block_dev_t *dev, uint32_t lba, uint32_t count, const void *buf);
+} block_dev_ops_t;
+
+struct block_dev {
+    const char *name;
+    uint32_t block_count;
+    const block_dev_ops_t *ops;
+    void *ctx;
+};
+
+// RAM disk over [base, base + bytes) (a boot module). Trailing bytes that do
+// not fill a block are ignored. Returns 0, or -1 if the range holds no block.
+int ramdisk_init(block_dev_t *dev, void *base, uint32_t bytes);
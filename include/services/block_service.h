@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "kernel/grant.h"
+#include "kernel/ipc.h"
+#include "services/block_dev.h"
+
+// Block service name
+#define BLOCK_SERVICE_NAME "block"
+
+// Most blocks one request may move.
+#define BLOCK_REQ_MAX_BLOCKS 16u
+
+// Payload of MSG_BLOCK_READ / MSG_BLOCK_WRITE: blocks [lba, lba + count) go
+// to (read) or come from (write) bytes [offset, ...) of a grant to the block
+// endpoint with GRANT_WRITE (read) or GRANT_READ (write). `tag` is echoed.
+typedef struct {
+    grant_id_t grant;
+    uint32_t offset;
+    uint32_t lba;
+    uint32_t count;
+    uint32_t tag;
+} block_req_t;
+
+// Payload of MSG_BLOCK_REPLY. status is 0, or -1 for a bad request or I/O error.
+typedef struct {
+    uint32_t tag;
+    int32_t status;
+    uint32_t count;
+} block_reply_t;
+
+typedef struct {
+    uint32_t requests;
+    uint32_t batches;          // processing passes that found requests
+    uint32_t hits;             // blocks served from the cache
+    uint32_t misses;           // blocks read from the device on demand
+    uint32_t readahead;        // blocks prefetched
+    uint32_t readahead_hits;   // prefetched blocks later requested
+    uint32_t device_ops;       // backend read/write calls
+    uint32_t errors;
+} block_stats_t;
+
+// Serve `dev` (NULL: no disk, the service stays down).
+void block_service_init(block_dev_t *dev);
+
+// Get block service endpoint
+endpoint_id_t block_service_get_endpoint(void);
+
+// Process pending messages (call periodically)
+void block_service_process(void);
+
+// Size of the disk in blocks (0 without one).
+uint32_t block_service_block_count(void);
+
+void block_service_get_stats(block_stats_t *out);
+
+// Drop every cached block and zero the counters (cold-cache benchmarks).
+void block_service_reset(void);
+
+// Blocks to prefetch past a sequential read; 0 disables read-ahead.
+// Returns the previous setting.
+uint32_t block_service_set_readahead(uint32_t blocks);
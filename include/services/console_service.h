@@ -13,3 +13,10 @@ endpoint_id_t console_service_get_endpoint(void);
 
 // Process pending messages (call periodically)
 void console_service_process(void);
+
+// Handle one message sent to ep (also the direct handler in MODE=monolithic)
+void console_service_handle(endpoint_id_t ep, const ipc_msg_t *msg);
+
+// Coalesce all log lines of one processing pass into a single flush
+// (default). Disabling writes every fragment as it arrives; used by `bench log`.
+void console_service_set_coalesce(int enabled);
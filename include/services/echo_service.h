@@ -13,3 +13,13 @@ endpoint_id_t echo_service_get_endpoint(void);
 
 // Process pending messages (call periodically)
 void echo_service_process(void);
+
+// Process pending messages on one echo instance's endpoint
+void echo_service_serve(endpoint_id_t ep);
+
+// Handle one message sent to ep (also the direct handler in MODE=monolithic)
+void echo_service_handle(endpoint_id_t ep, const ipc_msg_t *msg);
+
+// Start another echo instance on a new endpoint registered under
+// ECHO_SERVICE_NAME. Returns its task id (and *out_ep), or -1.
+int echo_service_spawn_replica(endpoint_id_t *out_ep);
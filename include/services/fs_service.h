@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "kernel/grant.h"
+#include "kernel/ipc.h"
+
+// File service name
+#define FS_SERVICE_NAME "fs"
+
+#define FS_MAX_FILES 64
+#define FS_PATH_MAX 64
+
+// Requests:
+//   MSG_FS_OPEN / MSG_FS_STAT  payload: NUL-terminated absolute path
+//   MSG_FS_READ                payload: fs_read_req_t
+// Every request is answered with MSG_FS_REPLY (fs_reply_t). A read hands
+// back a read-only grant of the archive pages holding the bytes, with
+// data.offset/length locating them; the client maps it, consumes the data,
+// unmaps and returns it with MSG_GRANT_DONE (payload: grant_done_t), sent
+// from the endpoint that made the read. A grant not returned may be revoked
+// once it is old and the service has run out of loans.
+typedef struct {
+    uint32_t fd;
+    uint32_t offset;
+    uint32_t length;
+} fs_read_req_t;
+
+typedef struct {
+    int32_t status;     // 0, or -1 (no such file, bad request, no grant left)
+    uint32_t fd;        // open: handle for MSG_FS_READ
+    uint32_t size;      // file size in bytes
+    uint32_t mode;      // permission bits from the archive
+    grant_ref_t data;   // read: where the bytes are (length 0 at end of file)
+} fs_reply_t;
+
+// Serve the ustar archive at [base, base + bytes) (NULL: no archive). The
+// path index is built by the first fs_service_process call.
+void fs_service_init(const void *base, uint32_t bytes);
+
+// Get file service endpoint
+endpoint_id_t fs_service_get_endpoint(void);
+
+// Process pending messages (call periodically)
+void fs_service_process(void);
+
+// Number of indexed files.
+uint32_t fs_service_file_count(void);
@@ -19,3 +19,27 @@ void monitor_service_process(void);
 
 // Report a service crash (called when crash detected)
 void monitor_report_crash(endpoint_id_t crashed_ep);
+
+// Heartbeats: a monitored service sends MSG_HEARTBEAT (sender = its endpoint)
+// every MONITOR_HEARTBEAT_INTERVAL cycles. With a deadline set, a service that
+// keeps getting scheduled but stays silent longer than that is restarted.
+// Restarts back off exponentially on repeated incidents and keep the endpoint
+// queue; each recovery logs its detection-to-recovery latency.
+#define MONITOR_HEARTBEAT_INTERVAL 10000000u
+void monitor_set_heartbeat_deadline(endpoint_id_t ep, uint32_t deadline_cycles);
+
+// Beat for `self` if the interval has passed since *last_beat (TSC low word).
+void monitor_heartbeat(endpoint_id_t self, uint32_t *last_beat);
+
+// Scale one service with replicas: spawn() starts an instance registered under
+// name and returns its task id (or -1). Up to max_replicas run besides the
+// primary, added while queues stay deep and retired after a long idle spell.
+typedef int (*monitor_spawn_fn_t)(endpoint_id_t *out_ep);
+void monitor_set_autoscale(const char *name, monitor_spawn_fn_t spawn, int max_replicas);
+
+// While paused no replica is added (benchmarks that load one instance on
+// purpose); idle replicas are still retired.
+void monitor_set_autoscale_paused(int paused);
+
+// Replicas currently running (including ones draining before retirement)
+int monitor_replica_count(void);
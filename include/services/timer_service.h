@@ -16,3 +16,10 @@ void timer_service_subscribe(endpoint_id_t subscriber);
 
 // Process/send timer ticks (call periodically)
 void timer_service_tick(void);
+
+// A MSG_TIMER_TICK sent to the timer endpoint asks for a tick: subscribers
+// get it, and the sender gets a MSG_TIMER_TICK reply with the tick count.
+void timer_service_handle(endpoint_id_t ep, const ipc_msg_t *msg);
+
+// Serve queued tick requests (the timer task's loop body)
+void timer_service_process(void);
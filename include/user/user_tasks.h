@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+// Entry points of ring-3 tasks (src/user/). Start them with
+// task_create_ex(..., TASK_FLAG_USER); the argument is passed on the user stack.
+
+// Echo service loop; arg is USER_ECHO_ARG(echo endpoint, monitor endpoint).
+// Pass ENDPOINT_INVALID as the monitor to send no heartbeats.
+#define USER_ECHO_ARG(ep, monitor_ep) \
+    ((void *)(uintptr_t)(((uint32_t)(ep) & 0xFFu) | (((uint32_t)(monitor_ep) & 0xFFu) << 8)))
+void echo_user_main(void *arg);
+
+// One-shot SYS_NULL timing task used by `bench`; arg is its request endpoint.
+void syscall_bench_user_main(void *arg);
@@ -0,0 +1,76 @@
+#pragma once
+
+// Ring-3 side of the system-call ABI (see kernel/syscall.h).
+// Only code under src/user/ may include this; it is linked into the user image.
+
+#include <stdint.h>
+
+#include "kernel/grant.h"
+#include "kernel/ipc.h"
+#include "kernel/syscall.h"
+
+// Extra results returned in EBX/ESI/EDI.
+typedef struct {
+    uint32_t ebx;
+    uint32_t esi;
+    uint32_t edi;
+} usys_out_t;
+
+// Raw entry points: SYSENTER fast path and the int 0x80 gate.
+uint32_t usys_sysenter(uint32_t nr, uint32_t a0, uint32_t a1, uint32_t a2, usys_out_t *out);
+uint32_t usys_int(uint32_t nr, uint32_t a0, uint32_t a1, uint32_t a2, usys_out_t *out);
+
+// Return address planted under a user task's entry point; exits the task.
+void user_task_exit(void);
+
+static inline void usys_yield(void) {
+    (void)usys_sysenter(SYS_YIELD, 0, 0, 0, 0);
+}
+
+static inline void usys_exit(void) {
+    (void)usys_sysenter(SYS_EXIT, 0, 0, 0, 0);
+}
+
+static inline ipc_error_t usys_ipc_send(endpoint_id_t dst, const ipc_msg_t *msg) {
+    return (ipc_error_t)usys_sysenter(SYS_IPC_SEND, dst, (uint32_t)(uintptr_t)msg, 0, 0);
+}
+
+// Payload of up to SYSCALL_SHORT_MAX bytes passed in registers (w0 = bytes 0-3).
+static inline ipc_error_t usys_ipc_send_short(endpoint_id_t dst, endpoint_id_t sender, msg_type_t type,
+                                              uint32_t len, uint32_t w0, uint32_t w1) {
+    return (ipc_error_t)usys_sysenter(SYS_IPC_SEND_SHORT, SYSCALL_HDR_PACK(dst, sender, type, len), w0, w1, 0);
+}
+
+// On success the header is in out->ebx (SYSCALL_HDR_*) and payload bytes 0-7
+// in out->esi/out->edi; longer messages are also copied in full to *buf.
+static inline ipc_error_t usys_ipc_recv(endpoint_id_t ep, ipc_msg_t *buf, usys_out_t *out) {
+    return (ipc_error_t)usys_sysenter(SYS_IPC_RECV, ep, (uint32_t)(uintptr_t)buf, 0, out);
+}
+
+// Shareable pages mapped into this task (see grant_buffer_alloc).
+static inline void *usys_buffer_alloc(uint32_t npages) {
+    return (void *)(uintptr_t)usys_sysenter(SYS_BUFFER_ALLOC, npages, 0, 0, 0);
+}
+
+static inline grant_id_t usys_grant_create(const void *addr, uint32_t npages, endpoint_id_t target,
+                                           uint32_t rights) {
+    return (grant_id_t)usys_sysenter(SYS_GRANT_CREATE, (uint32_t)(uintptr_t)addr, npages | (rights << 16),
+                                     target, 0);
+}
+
+// Returns the mapped address, or NULL on failure.
+static inline void *usys_grant_map(grant_id_t id, endpoint_id_t self, uint32_t rights) {
+    usys_out_t out;
+    if (usys_sysenter(SYS_GRANT_MAP, id, self, rights, &out) != 0) {
+        return 0;
+    }
+    return (void *)(uintptr_t)out.ebx;
+}
+
+static inline int usys_grant_unmap(grant_id_t id) {
+    return (int)usys_sysenter(SYS_GRANT_UNMAP, id, 0, 0, 0);
+}
+
+static inline int usys_grant_revoke(grant_id_t id) {
+    return (int)usys_sysenter(SYS_GRANT_REVOKE, id, 0, 0, 0);
+}
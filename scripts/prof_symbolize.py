@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Symbolize a `prof dump` capture against build/kernel.elf.
+
+Reads the serial log (a file, or stdin), keeps the @prof lines and prints a
+flat profile: samples per function, self and inclusive. With --folded, also
+writes folded stacks ("task;outer;...;leaf count"), the input format of
+flamegraph.pl and speedscope.
+
+    qemu-system-i386 ... -serial file:serial.log    # then `prof start`, `prof dump`
+    scripts/prof_symbolize.py serial.log --folded prof.folded
+    flamegraph.pl prof.folded > prof.svg
+"""
+
+import argparse
+import bisect
+import collections
+import subprocess
+import sys
+
+
+def load_symbols(elf, nm):
+    out = subprocess.run([nm, "-n", "--defined-only", elf], check=True, capture_output=True, text=True).stdout
+    addrs, names = [], []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) != 3 or parts[1] not in "tTwW":
+            continue
+        addrs.append(int(parts[0], 16))
+        names.append(parts[2])
+    return addrs, names
+
+
+def symbolize(addrs, names, pc):
+    i = bisect.bisect_right(addrs, pc) - 1
+    return names[i] if i >= 0 else "0x%08x" % pc
+
+
+def parse(lines):
+    tasks = {-1: "scheduler"}
+    samples = []
+    header = {}
+    for raw in lines:
+        line = raw.strip().replace("\r", "")
+        if line.startswith("@prof-begin"):
+            header = dict(kv.split("=", 1) for kv in line.split()[1:])
+            samples = []
+        elif line.startswith("@prof-task"):
+            kv = dict(kv.split("=", 1) for kv in line.split()[1:])
+            tasks[int(kv["id"])] = kv["name"]
+        elif line.startswith("@prof "):
+            kv = dict(kv.split("=", 1) for kv in line.split()[1:])
+            stack = [int(a, 16) for a in kv.get("stack", "").split(",") if a]
+            samples.append((int(kv["task"]), int(kv["ring"]), int(kv["pc"], 16), stack))
+    return header, tasks, samples
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("log", nargs="?", help="serial log with a prof dump (default: stdin)")
+    ap.add_argument("--elf", default="build/kernel.elf")
+    ap.add_argument("--nm", default="nm")
+    ap.add_argument("--folded", help="write folded stacks to this file")
+    ap.add_argument("--top", type=int, default=30, help="rows in the flat profile")
+    args = ap.parse_args()
+
+    with (open(args.log, errors="replace") if args.log else sys.stdin) as f:
+        header, tasks, samples = parse(f)
+    if not samples:
+        sys.exit("no @prof samples found (run `prof dump` with serial captured)")
+    addrs, names = load_symbols(args.elf, args.nm)
+
+    self_count = collections.Counter()
+    incl_count = collections.Counter()
+    per_task = collections.Counter()
+    folded = collections.Counter()
+    for task, ring, pc, stack in samples:
+        tname = tasks.get(task, "task%d" % task)
+        frames = [symbolize(addrs, names, pc)] + [symbolize(addrs, names, a - 1) for a in stack]
+        if ring == 3:
+            frames[0] += " [user]"
+        self_count[frames[0]] += 1
+        for fn in set(frames):
+            incl_count[fn] += 1
+        per_task[tname] += 1
+        folded[";".join([tname] + frames[::-1])] += 1
+
+    total = len(samples)
+    print("%d samples, %s Hz, every %s tick(s), %s overwritten" % (
+        total, header.get("hz", "?"), header.get("every", "?"), header.get("overwritten", "?")))
+    print()
+    print("%8s %7s %8s %7s  %s" % ("self", "self%", "incl", "incl%", "function"))
+    for fn, n in self_count.most_common(args.top):
+        print("%8d %6.2f%% %8d %6.2f%%  %s" % (n, 100.0 * n / total, incl_count[fn], 100.0 * incl_count[fn] / total, fn))
+    print()
+    print("%8s %7s  %s" % ("samples", "%", "task"))
+    for tname, n in per_task.most_common():
+        print("%8d %6.2f%%  %s" % (n, 100.0 * n / total, tname))
+
+    if args.folded:
+        with open(args.folded, "w") as out:
+            for stack, n in sorted(folded.items()):
+                out.write("%s %d\n" % (stack, n))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Convert a `trace dump` capture into Chrome trace JSON.
+
+Reads the serial log (a file, or stdin) and writes a trace that loads in
+chrome://tracing, Perfetto (ui.perfetto.dev) or speedscope:
+
+  * one thread per task; switch_in/switch_out become "running" slices
+  * IPC sends and receives are instant events; a send is linked to the
+    receive that dequeued it by a flow arrow (queues are FIFO per endpoint)
+  * service dispatch, task restarts and crashes are instant events
+
+    scripts/trace2chrome.py serial.log -o trace.json
+"""
+
+import argparse
+import collections
+import json
+import re
+import sys
+
+SCHEDULER_TID = 999
+
+
+def load_msg_types(header):
+    """Message type names, in enum order, from msg_type_t in kernel/ipc.h."""
+    try:
+        text = open(header).read()
+    except OSError:
+        return {}
+    body = re.search(r"typedef enum \{(.*?)\} msg_type_t;", text, re.S)
+    if not body:
+        return {}
+    names = re.findall(r"^\s*(MSG_\w+)", body.group(1), re.M)
+    return dict(enumerate(names))
+
+
+def parse(lines):
+    header, tasks, records = {}, {}, []
+    for raw in lines:
+        line = raw.strip().replace("\r", "")
+        if not line.startswith("@trace"):
+            continue
+        tag, _, rest = line.partition(" ")
+        kv = dict(item.split("=", 1) for item in rest.split() if "=" in item)
+        if tag == "@trace-begin":
+            header, tasks, records = kv, {}, []
+        elif tag == "@trace-task":
+            tasks[int(kv["id"])] = kv["name"]
+        elif tag == "@trace":
+            records.append((int(kv["t"]), int(kv["cpu"]), int(kv["task"]), kv["ev"], int(kv["a0"]), int(kv["a1"])))
+    return header, tasks, records
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("log", nargs="?", help="serial log with a trace dump (default: stdin)")
+    ap.add_argument("-o", "--output", default="trace.json")
+    ap.add_argument("--ipc-header", default="include/kernel/ipc.h", help="for message type names")
+    args = ap.parse_args()
+
+    with (open(args.log, errors="replace") if args.log else sys.stdin) as f:
+        header, tasks, records = parse(f)
+    if not records:
+        sys.exit("no @trace records found (run `trace dump` with serial captured)")
+    khz = int(header.get("tsc_khz", "0")) or 1000000
+    msg_types = load_msg_types(args.ipc_header)
+    t0 = records[0][0]
+
+    def us(tsc):
+        return (tsc - t0) * 1000.0 / khz
+
+    def tid(task):
+        return SCHEDULER_TID if task < 0 else task
+
+    def type_name(t):
+        return msg_types.get(t, "type%d" % t)
+
+    events = [{"ph": "M", "pid": 0, "tid": SCHEDULER_TID, "name": "thread_name", "args": {"name": "scheduler"}}]
+    for task_id, name in sorted(tasks.items()):
+        events.append({"ph": "M", "pid": 0, "tid": task_id, "name": "thread_name",
+                       "args": {"name": "%s (%d)" % (name, task_id)}})
+
+    running = {}
+    in_flight = collections.defaultdict(collections.deque)
+    flow_id = 0
+    for tsc, cpu, task, ev, a0, a1 in records:
+        ts = us(tsc)
+        base = {"pid": cpu, "ts": ts}
+        if ev == "switch_in":
+            running[a0] = ts
+        elif ev == "switch_out":
+            start = running.pop(a0, None)
+            if start is not None:
+                name = "running" + (" (exit)" if a1 else "")
+                events.append(dict(base, ph="X", tid=a0, ts=start, dur=ts - start, name=name, args={"runs": a1}))
+        elif ev == "ipc_send":
+            flow_id += 1
+            in_flight[a0].append((flow_id, a1))
+            name = "send %s -> ep%d" % (type_name(a1), a0)
+            events.append(dict(base, ph="i", s="t", tid=tid(task), name=name, cat="ipc"))
+            events.append(dict(base, ph="s", tid=tid(task), id=flow_id, name="msg", cat="ipc"))
+        elif ev == "ipc_recv":
+            name = "recv %s <- ep%d" % (type_name(a1), a0)
+            events.append(dict(base, ph="i", s="t", tid=tid(task), name=name, cat="ipc"))
+            queue = in_flight[a0]
+            if queue and queue[0][1] == a1:
+                fid, _ = queue.popleft()
+                events.append(dict(base, ph="f", bp="e", tid=tid(task), id=fid, name="msg", cat="ipc"))
+            else:
+                queue.clear()  # the matching send predates the ring
+        elif ev == "svc_dispatch":
+            events.append(dict(base, ph="i", s="t", tid=tid(task), name="dispatch %s" % type_name(a1), cat="svc",
+                               args={"endpoint": a0}))
+        elif ev == "task_restart":
+            events.append(dict(base, ph="i", s="g", tid=tid(task), name="restart task %d" % a0, cat="task"))
+        elif ev == "crash":
+            events.append(dict(base, ph="i", s="g", tid=tid(task), name="crash ep%d" % a0, cat="task"))
+        else:
+            events.append(dict(base, ph="i", s="t", tid=tid(task), name=ev, args={"a0": a0, "a1": a1}))
+
+    with open(args.output, "w") as out:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ns",
+                   "otherData": {"tsc_khz": khz, "overwritten": header.get("overwritten", "0")}}, out)
+    print("%d records -> %d events in %s" % (len(records), len(events), args.output))
+
+
+if __name__ == "__main__":
+    main()
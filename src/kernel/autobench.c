@@ -0,0 +1,100 @@
+#include "kernel/autobench.h"
+
+#include <stddef.h>
+
+#include "kernel/bench.h"
+#include "kernel/io.h"
+#include "kernel/kprintf.h"
+#include "kernel/multiboot2.h"
+#include "kernel/serial.h"
+
+#define SUITE_NAME_MAX 16
+
+typedef struct {
+    const char *name;
+    int (*run)(uint32_t n);
+} autobench_suite_t;
+
+static const autobench_suite_t g_suites[] = {
+    { "ipc", bench_ipc },
+    { "sched", bench_sched },
+    { "ops", bench_ops },
+    { "mem", bench_mem },
+};
+
+void qemu_debug_exit(uint8_t code) {
+    serial_flush();
+    outb(QEMU_DEBUG_EXIT_PORT, code);
+}
+
+int autobench_requested(void) {
+    const char *v = multiboot2_cmdline_get("autobench");
+    return v != NULL && *v != '\0' && *v != ' ';
+}
+
+static uint32_t parse_iterations(void) {
+    const char *v = multiboot2_cmdline_get("iterations");
+    uint32_t n = 0;
+    int any = 0;
+    while (v != NULL && *v >= '0' && *v <= '9') {
+        n = n * 10u + (uint32_t)(*v - '0');
+        any = 1;
+        v++;
+    }
+    return any && n > 0 ? n : AUTOBENCH_DEFAULT_ITERATIONS;
+}
+
+static const autobench_suite_t *find_suite(const char *name) {
+    for (size_t i = 0; i < sizeof(g_suites) / sizeof(g_suites[0]); i++) {
+        const char *a = g_suites[i].name;
+        const char *b = name;
+        while (*a != '\0' && *a == *b) {
+            a++;
+            b++;
+        }
+        if (*a == '\0' && *b == '\0') {
+            return &g_suites[i];
+        }
+    }
+    return NULL;
+}
+
+autobench_status_t autobench_run(void) {
+    const char *list = multiboot2_cmdline_get("autobench");
+    uint32_t n = parse_iterations();
+    autobench_status_t status = AUTOBENCH_OK;
+
+    kprintf("@autobench-begin iterations=%u samples=%u\n", n, n < BENCH_MAX_SAMPLES ? n : BENCH_MAX_SAMPLES);
+    // Comma-separated names, up to the next space.
+    while (list != NULL && *list != '\0' && *list != ' ') {
+        char name[SUITE_NAME_MAX];
+        size_t len = 0;
+        while (*list != '\0' && *list != ' ' && *list != ',') {
+            if (len + 1 < sizeof(name)) {
+                name[len++] = *list;
+            }
+            list++;
+        }
+        name[len] = '\0';
+        if (*list == ',') {
+            list++;
+        }
+        if (len == 0) {
+            continue;
+        }
+
+        const autobench_suite_t *suite = find_suite(name);
+        if (suite == NULL) {
+            kprintf("autobench: unknown suite '%s'\n", name);
+            status = AUTOBENCH_BAD_ARGS;
+            break;
+        }
+        if (suite->run(n) != 0) {
+            status = AUTOBENCH_SUITE_FAILED;
+        }
+        serial_flush();
+    }
+    kprintf("@autobench-end status=%u\n", (uint32_t)status);
+    serial_flush();
+    return status;
+}
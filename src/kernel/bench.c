@@ -0,0 +1,104 @@
+#include "kernel/bench.h"
+
+#include <stddef.h>
+
+#include "kernel/kprintf.h"
+#include "kernel/serial.h"
+#include "kernel/timing.h"
+#include "kernel/util.h"
+
+// Shell sort (Ciura gaps): in place, no allocation, fine for a few thousand.
+static void sort_u32(uint32_t *v, uint32_t n) {
+    static const uint32_t gaps[] = { 701, 301, 132, 57, 23, 10, 4, 1 };
+    for (uint32_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++) {
+        uint32_t gap = gaps[g];
+        for (uint32_t i = gap; i < n; i++) {
+            uint32_t x = v[i];
+            uint32_t j = i;
+            while (j >= gap && v[j - gap] > x) {
+                v[j] = v[j - gap];
+                j -= gap;
+            }
+            v[j] = x;
+        }
+    }
+}
+
+// Nearest-rank percentile of a sorted array.
+static uint32_t percentile(const uint32_t *sorted, uint32_t n, uint32_t pct) {
+    uint32_t rank = (pct * n + 99u) / 100u;
+    return sorted[rank ? rank - 1 : 0];
+}
+
+uint32_t bench_samples[BENCH_MAX_SAMPLES];
+
+static uint64_t to_unit(uint64_t cycles, int ns) {
+    return ns ? clock_cycles_to_ns(cycles) : cycles;
+}
+
+static void summarize(uint32_t *cycles, uint32_t n, bench_summary_t *out, int ns) {
+    bench_summary_t zero = { 0 };
+    *out = zero;
+    out->unit = ns ? "ns" : "cycles";
+    if (n == 0) {
+        return;
+    }
+    sort_u32(cycles, n);
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        sum += cycles[i];
+    }
+    out->n = n;
+    out->min = to_unit(cycles[0], ns);
+    out->p50 = to_unit(percentile(cycles, n, 50), ns);
+    out->p90 = to_unit(percentile(cycles, n, 90), ns);
+    out->p99 = to_unit(percentile(cycles, n, 99), ns);
+    out->max = to_unit(cycles[n - 1], ns);
+    out->mean = to_unit(u64_div_u32(sum, n, NULL), ns);
+}
+
+void bench_summarize(uint32_t *cycles, uint32_t n, bench_summary_t *out) {
+    summarize(cycles, n, out, 1);
+}
+
+void bench_summarize_cycles(uint32_t *cycles, uint32_t n, bench_summary_t *out) {
+    summarize(cycles, n, out, 0);
+}
+
+// With interrupts on, a full TX ring drops bytes, and a suite prints its lines
+// faster than a slow UART sends them. Draining the ring first leaves room for
+// a whole line, so `make bench` never sees a cut one. Called between samples,
+// never inside a timed region.
+static void bench_line_room(void) {
+    serial_flush();
+}
+
+void bench_begin(const char *suite, uint32_t version) {
+    bench_line_room();
+    kprintf("@bench-begin suite=%s version=%u tsc_khz=%u source=%s\n", suite, version, clock_tsc_khz(),
+            clock_source());
+}
+
+void bench_end(const char *suite) {
+    bench_line_room();
+    kprintf("@bench-end suite=%s\n", suite);
+    serial_flush(); // autobench may power off right after the last suite
+}
+
+void bench_report(const char *suite, const char *params, const bench_summary_t *s) {
+    bench_line_room();
+    kprintf("@bench suite=%s %s n=%u min=%llu p50=%llu p90=%llu p99=%llu max=%llu mean=%llu unit=%s\n", suite,
+            params, s->n, s->min, s->p50, s->p90, s->p99, s->max, s->mean, s->unit);
+}
+
+void bench_report_bandwidth(const char *suite, const char *params, const bench_summary_t *s, uint32_t bytes) {
+    // MB/s = bytes / (p50 / (tsc_khz * 1000)) / 10^6.
+    uint32_t p50 = s->p50 > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)s->p50;
+    uint64_t mb_s = 0;
+    if (p50 != 0) {
+        mb_s = u64_div_u32(u64_div_u32((uint64_t)bytes * clock_tsc_khz(), p50, NULL), 1000u, NULL);
+    }
+    bench_line_room();
+    kprintf("@bench suite=%s %s n=%u min=%llu p50=%llu p90=%llu p99=%llu max=%llu mean=%llu unit=%s mb_s=%llu\n",
+            suite, params, s->n, s->min, s->p50, s->p90, s->p99, s->max, s->mean, s->unit, mb_s);
+}
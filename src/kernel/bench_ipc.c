@@ -0,0 +1,220 @@
+#include "kernel/bench.h"
+
+#include <stddef.h>
+
+#include "kernel/ipc.h"
+#include "kernel/kprintf.h"
+#include "kernel/task.h"
+#include "kernel/timing.h"
+#include "services/echo_service.h"
+#include "services/monitor_service.h"
+
+#define BENCH_IPC_VERSION 1u
+#define BENCH_IPC_MAX_CLIENTS 4
+// Give up on a case after this many fruitless yields (echo died mid-run).
+#define BENCH_IPC_IDLE_LIMIT 100000u
+
+typedef struct {
+    endpoint_id_t server;
+    endpoint_id_t reply_ep;
+    uint32_t payload;
+    uint32_t count;
+    uint32_t *samples;
+    int done;
+    int failed;
+} ipc_client_t;
+
+static endpoint_id_t g_reply_eps[BENCH_IPC_MAX_CLIENTS];
+static int g_reply_eps_ready;
+static ipc_client_t g_clients[BENCH_IPC_MAX_CLIENTS];
+
+static void fill_request(ipc_msg_t *msg, endpoint_id_t reply_ep, uint32_t payload, uint32_t seq) {
+    msg->type = MSG_ECHO;
+    msg->sender = reply_ep;
+    msg->payload_len = payload;
+    for (uint32_t i = 0; i < payload; i++) {
+        msg->payload[i] = (uint8_t)i;
+    }
+    if (payload >= sizeof(uint32_t)) {
+        *(uint32_t *)msg->payload = seq;
+    }
+}
+
+// Wait for the next echo reply on ep. Returns 0, or -1 after too many yields.
+static int wait_reply(endpoint_id_t ep, ipc_msg_t *reply) {
+    for (uint32_t idle = 0; idle < BENCH_IPC_IDLE_LIMIT; idle++) {
+        if (ipc_recv(ep, reply) == IPC_SUCCESS && reply->type == MSG_ECHO_REPLY) {
+            return 0;
+        }
+        task_yield();
+    }
+    return -1;
+}
+
+// One request in flight: each sample is send to reply, scheduling included.
+static void run_lockstep(ipc_client_t *c) {
+    ipc_msg_t msg;
+    ipc_msg_t reply;
+    for (uint32_t i = 0; i < c->count; i++) {
+        fill_request(&msg, c->reply_ep, c->payload, i);
+        tsc_t t0 = tsc_bench_start();
+        while (ipc_send(c->server, &msg) == IPC_ERR_QUEUE_FULL) {
+            task_yield();
+        }
+        if (wait_reply(c->reply_ep, &reply) != 0) {
+            c->failed = 1;
+            return;
+        }
+        c->samples[i] = bench_delta(tsc_to_u64(tsc_bench_stop()), tsc_to_u64(t0));
+    }
+}
+
+static void client_task(void *arg) {
+    ipc_client_t *c = arg;
+    run_lockstep(c);
+    c->done = 1;
+}
+
+// Up to `depth` requests in flight; a reply is matched to its send time
+// through the sequence number carried in the payload.
+static int run_pipelined(endpoint_id_t server, endpoint_id_t reply_ep, uint32_t depth, uint32_t n) {
+    uint64_t sent_at[IPC_QUEUE_SIZE];
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t idle = 0;
+    ipc_msg_t msg;
+    while (received < n) {
+        ipc_msg_t reply;
+        while (ipc_recv(reply_ep, &reply) == IPC_SUCCESS) {
+            if (reply.type != MSG_ECHO_REPLY) {
+                continue;
+            }
+            uint32_t seq = *(const uint32_t *)reply.payload;
+            bench_samples[received++] = bench_delta(tsc_to_u64(tsc_bench_stop()), sent_at[seq % IPC_QUEUE_SIZE]);
+            idle = 0;
+        }
+        if (sent < n && sent - received < depth) {
+            fill_request(&msg, reply_ep, sizeof(uint32_t) * 2u, sent);
+            sent_at[sent % IPC_QUEUE_SIZE] = tsc_to_u64(tsc_bench_start());
+            if (ipc_send(server, &msg) == IPC_SUCCESS) {
+                sent++;
+                continue;
+            }
+        }
+        if (++idle > BENCH_IPC_IDLE_LIMIT) {
+            return -1;
+        }
+        task_yield();
+    }
+    return 0;
+}
+
+// `clients` lock-step clients at once: the CLI is client 0, the rest run as
+// short-lived tasks. Samples land in consecutive slices of bench_samples.
+// Returns the number of samples taken, or 0 on failure; *out_started is the
+// number of clients that actually ran (task slots may run out).
+static uint32_t run_clients(endpoint_id_t server, uint32_t payload, int clients, uint32_t n, int *out_started) {
+    uint32_t per = n / (uint32_t)clients;
+    int started = 1;
+    for (int i = 0; i < clients; i++) {
+        ipc_client_t *c = &g_clients[i];
+        c->server = server;
+        c->reply_ep = g_reply_eps[i];
+        c->payload = payload;
+        c->count = per;
+        c->samples = &bench_samples[(uint32_t)i * per];
+        c->done = 0;
+        c->failed = 0;
+        if (i > 0) {
+            if (task_create("ipcbench", client_task, c) < 0) {
+                break;
+            }
+            started++;
+        }
+    }
+    run_lockstep(&g_clients[0]);
+    for (int i = 1; i < started; i++) {
+        while (!g_clients[i].done) {
+            task_yield();
+        }
+    }
+    *out_started = started;
+    for (int i = 0; i < started; i++) {
+        if (g_clients[i].failed) {
+            return 0;
+        }
+    }
+    return per * (uint32_t)started;
+}
+
+static void report(const char *params, uint32_t n) {
+    bench_summary_t s;
+    bench_summarize(bench_samples, n, &s);
+    bench_report("ipc", params, &s);
+}
+
+int bench_ipc(uint32_t n) {
+    if (n > BENCH_MAX_SAMPLES) {
+        n = BENCH_MAX_SAMPLES;
+    }
+    if (n < BENCH_IPC_MAX_CLIENTS) {
+        n = BENCH_IPC_MAX_CLIENTS;
+    }
+    endpoint_id_t server = echo_service_get_endpoint();
+    if (server == ENDPOINT_INVALID) {
+        kprintf("bench ipc: echo service not available\n");
+        return -1;
+    }
+    // Reply endpoints are kept across runs.
+    for (; g_reply_eps_ready < BENCH_IPC_MAX_CLIENTS; g_reply_eps_ready++) {
+        g_reply_eps[g_reply_eps_ready] = ipc_endpoint_create();
+        if (g_reply_eps[g_reply_eps_ready] == ENDPOINT_INVALID) {
+            kprintf("bench ipc: out of endpoints\n");
+            return -1;
+        }
+    }
+
+    // Pipelined cases keep the echo queue deep; replicas would only add noise.
+    monitor_set_autoscale_paused(1);
+    bench_begin("ipc", BENCH_IPC_VERSION);
+    char params[64];
+
+    static const uint32_t payloads[] = { 0, 4, 8, 16, 32, 48, IPC_MAX_PAYLOAD };
+    for (uint32_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++) {
+        int started;
+        if (run_clients(server, payloads[i], 1, n, &started) == 0) {
+            goto failed;
+        }
+        ksnprintf(params, sizeof(params), "case=payload mode=lockstep size=%u depth=1 clients=1", payloads[i]);
+        report(params, n);
+    }
+
+    for (uint32_t depth = 1; depth <= IPC_QUEUE_SIZE; depth <<= 1) {
+        if (run_pipelined(server, g_reply_eps[0], depth, n) != 0) {
+            goto failed;
+        }
+        ksnprintf(params, sizeof(params), "case=depth mode=%s size=8 depth=%u clients=1",
+                  depth == 1 ? "lockstep" : "pipelined", depth);
+        report(params, n);
+    }
+
+    for (int clients = 1; clients <= BENCH_IPC_MAX_CLIENTS; clients++) {
+        int started;
+        uint32_t got = run_clients(server, 8, clients, n, &started);
+        if (got == 0) {
+            goto failed;
+        }
+        ksnprintf(params, sizeof(params), "case=clients mode=lockstep size=8 depth=1 clients=%d", started);
+        report(params, got);
+    }
+
+    bench_end("ipc");
+    monitor_set_autoscale_paused(0);
+    return 0;
+
+failed:
+    kprintf("bench ipc: echo stopped answering\n");
+    bench_end("ipc");
+    monitor_set_autoscale_paused(0);
+    return -1;
+}
@@ -0,0 +1,133 @@
+#include "kernel/bench.h"
+
+#include <stddef.h>
+
+#include "kernel/ipc.h"
+#include "kernel/kprintf.h"
+#include "kernel/task.h"
+#include "kernel/timing.h"
+#include "services/console_service.h"
+#include "services/echo_service.h"
+#include "services/monitor_service.h"
+#include "services/timer_service.h"
+
+#define BENCH_OPS_VERSION 2u
+// Every log request prints a line; keep the console case short.
+#define BENCH_OPS_LOG_MAX 100u
+#define BENCH_OPS_IDLE_LIMIT 100000u
+
+#ifdef CONFIG_MONOLITHIC
+#define BENCH_OPS_MODE "monolithic"
+#else
+#define BENCH_OPS_MODE "microkernel"
+#endif
+
+static endpoint_id_t g_reply_ep = ENDPOINT_INVALID;
+
+// Request/reply: send, then wait for `reply_type` on our endpoint.
+static int run_call(endpoint_id_t server, msg_type_t type, msg_type_t reply_type, uint32_t payload, uint32_t n) {
+    ipc_msg_t msg;
+    msg.type = type;
+    msg.sender = g_reply_ep;
+    msg.payload_len = payload;
+    for (uint32_t i = 0; i < payload; i++) {
+        msg.payload[i] = (uint8_t)i;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        tsc_t t0 = tsc_bench_start();
+        while (ipc_send(server, &msg) == IPC_ERR_QUEUE_FULL) {
+            task_yield();
+        }
+        ipc_msg_t reply;
+        uint32_t idle = 0;
+        while (ipc_recv(g_reply_ep, &reply) != IPC_SUCCESS || reply.type != reply_type) {
+            if (++idle > BENCH_OPS_IDLE_LIMIT) {
+                return -1;
+            }
+            task_yield();
+        }
+        bench_samples[i] = bench_delta(tsc_to_u64(tsc_bench_stop()), tsc_to_u64(t0));
+    }
+    return 0;
+}
+
+// One-way: a log line counts as done once the console has taken it off its
+// queue (at once when the send is a direct call). Coalescing is off, so in both
+// modes that includes writing the line to VGA and serial.
+static int run_log(endpoint_id_t console, uint32_t n) {
+    ipc_msg_t msg;
+    msg.type = MSG_LOG;
+    msg.sender = ENDPOINT_INVALID;
+    msg.payload_len = 6;
+    for (uint32_t i = 0; i < 6; i++) {
+        msg.payload[i] = (uint8_t)"bench\n"[i];
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        tsc_t t0 = tsc_bench_start();
+        if (ipc_send(console, &msg) != IPC_SUCCESS) {
+            return -1;
+        }
+        uint32_t idle = 0;
+        while (ipc_queue_depth(console) != 0) {
+            if (++idle > BENCH_OPS_IDLE_LIMIT) {
+                return -1;
+            }
+            task_yield();
+        }
+        bench_samples[i] = bench_delta(tsc_to_u64(tsc_bench_stop()), tsc_to_u64(t0));
+    }
+    return 0;
+}
+
+static void report(const char *op, uint32_t size, uint32_t n) {
+    char params[64];
+    bench_summary_t s;
+    ksnprintf(params, sizeof(params), "op=%s mode=%s size=%u", op, BENCH_OPS_MODE, size);
+    bench_summarize(bench_samples, n, &s);
+    bench_report("ops", params, &s);
+}
+
+int bench_ops(uint32_t n) {
+    if (n > BENCH_MAX_SAMPLES) {
+        n = BENCH_MAX_SAMPLES;
+    }
+    if (n == 0) {
+        n = 1;
+    }
+    if (g_reply_ep == ENDPOINT_INVALID) {
+        g_reply_ep = ipc_endpoint_create();
+        if (g_reply_ep == ENDPOINT_INVALID) {
+            kprintf("bench ops: out of endpoints\n");
+            return -1;
+        }
+    }
+
+    int rc = 0;
+    monitor_set_autoscale_paused(1);
+    bench_begin("ops", BENCH_OPS_VERSION);
+    if (run_call(echo_service_get_endpoint(), MSG_ECHO, MSG_ECHO_REPLY, 32, n) == 0) {
+        report("echo", 32, n);
+    } else {
+        rc = -1;
+    }
+    if (run_call(timer_service_get_endpoint(), MSG_TIMER_TICK, MSG_TIMER_TICK, 0, n) == 0) {
+        report("timer_tick", 0, n);
+    } else {
+        rc = -1;
+    }
+    uint32_t logs = n < BENCH_OPS_LOG_MAX ? n : BENCH_OPS_LOG_MAX;
+    console_service_set_coalesce(0);
+    int log_rc = run_log(console_service_get_endpoint(), logs);
+    console_service_set_coalesce(1);
+    if (log_rc == 0) {
+        report("log", 6, logs);
+    } else {
+        rc = -1;
+    }
+    bench_end("ops");
+    monitor_set_autoscale_paused(0);
+    if (rc != 0) {
+        kprintf("bench ops: a service stopped answering\n");
+    }
+    return rc;
+}
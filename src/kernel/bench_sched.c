@@ -0,0 +1,222 @@
+#include "kernel/bench.h"
+
+#include <stddef.h>
+
+#include "kernel/fpu.h"
+#include "kernel/kprintf.h"
+#include "kernel/paging.h"
+#include "kernel/task.h"
+#include "kernel/timing.h"
+
+#define BENCH_SCHED_VERSION 1u
+#define PROBE_STACK_WORDS 512u
+
+extern void ctx_switch(uint32_t **old_sp, uint32_t *new_sp, uint32_t new_cr3);
+
+// ctx_switch probe: a bare context on its own stack, outside the task table,
+// that bounces straight back. Both directions are sampled.
+static uint32_t g_probe_stack[PROBE_STACK_WORDS] __attribute__((aligned(16)));
+static uint32_t *g_probe_sp;
+static uint32_t *g_main_sp;
+static uint32_t g_probe_cr3;
+static uint64_t g_switch_at;
+static uint32_t g_switch_count;
+
+static int g_spin_stop;
+static int g_spinners;
+
+__attribute__((noreturn)) static void probe_entry(void) {
+    for (;;) {
+        bench_samples[g_switch_count++] = bench_delta(tsc_to_u64(tsc_bench_stop()), g_switch_at);
+        g_switch_at = tsc_to_u64(tsc_bench_start());
+        ctx_switch(&g_probe_sp, g_main_sp, g_probe_cr3);
+    }
+}
+
+static void noop_task(void *arg) {
+    (void)arg;
+}
+
+static void spinner_task(void *arg) {
+    (void)arg;
+    while (!g_spin_stop) {
+        task_yield();
+    }
+    g_spinners--;
+}
+
+// One x87 instruction: enough to make the caller the FPU owner (kernel/fpu.h).
+static void fpu_touch(void) {
+    __asm__ volatile("fldz\n\tfstp %%st(0)" : : : "memory");
+}
+
+static void fpu_spinner_task(void *arg) {
+    (void)arg;
+    while (!g_spin_stop) {
+        fpu_touch();
+        task_yield();
+    }
+    g_spinners--;
+}
+
+static int count_runnable(void) {
+    int runnable = 0;
+    for (int i = 0; i < MAX_TASKS; i++) {
+        task_info_t info;
+        if (task_get_info(i, &info) == 0 && info.running) {
+            runnable++;
+        }
+    }
+    return runnable;
+}
+
+static void report(const char *params, uint32_t n) {
+    bench_summary_t s;
+    bench_summarize_cycles(bench_samples, n, &s);
+    bench_report("sched", params, &s);
+}
+
+// Same frame task_prepare_stack builds: RET, EFLAGS, then pushal's eight words.
+static void run_ctx_switch(uint32_t n) {
+    uint32_t *sp = &g_probe_stack[PROBE_STACK_WORDS];
+    *(--sp) = 0; // fake return address for probe_entry
+    *(--sp) = (uint32_t)(uintptr_t)probe_entry;
+    *(--sp) = 0x202u;
+    for (int i = 0; i < 8; i++) {
+        *(--sp) = 0;
+    }
+    g_probe_sp = sp;
+    g_probe_cr3 = paging_read_cr3();
+    g_switch_count = 0;
+    while (g_switch_count + 2u <= n) {
+        g_switch_at = tsc_to_u64(tsc_bench_start());
+        ctx_switch(&g_main_sp, g_probe_sp, g_probe_cr3);
+        bench_samples[g_switch_count++] = bench_delta(tsc_to_u64(tsc_bench_stop()), g_switch_at);
+    }
+    report("case=ctx_switch", g_switch_count);
+}
+
+static void sample_yields(uint32_t n, int hinted, int use_fpu) {
+    int self = task_get_current();
+    for (uint32_t i = 0; i < n; i++) {
+        tsc_t t0 = tsc_bench_start();
+        if (hinted) {
+            task_run_next(self);
+        }
+        task_yield();
+        if (use_fpu) {
+            fpu_touch();
+        }
+        bench_samples[i] = bench_delta(tsc_to_u64(tsc_bench_stop()), tsc_to_u64(t0));
+    }
+}
+
+static int run_create_restart(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        tsc_t t0 = tsc_bench_start();
+        int id = task_create("schedbench", noop_task, NULL);
+        tsc_t t1 = tsc_bench_stop();
+        if (id < 0) {
+            return -1;
+        }
+        bench_samples[i] = bench_delta(tsc_to_u64(t1), tsc_to_u64(t0));
+        (void)task_kill(id);
+    }
+    char params[48];
+    ksnprintf(params, sizeof(params), "case=task_create stack=%u", TASK_STACK_DEFAULT);
+    report(params, n);
+
+    // The task never gets to run: each restart just repaints its stack again.
+    int id = task_create("schedbench", noop_task, NULL);
+    if (id < 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        tsc_t t0 = tsc_bench_start();
+        (void)task_restart(id);
+        bench_samples[i] = bench_delta(tsc_to_u64(tsc_bench_stop()), tsc_to_u64(t0));
+    }
+    (void)task_kill(id);
+    ksnprintf(params, sizeof(params), "case=task_restart stack=%u", TASK_STACK_DEFAULT);
+    report(params, n);
+    return 0;
+}
+
+// Plain yields go round every runnable task, so add spinners (tasks that
+// only yield) one at a time until the table is full.
+static void run_yield_sweep(uint32_t n) {
+    char params[48];
+    g_spin_stop = 0;
+    g_spinners = 0;
+    for (;;) {
+        int runnable = count_runnable();
+        sample_yields(n, 0, 0);
+        ksnprintf(params, sizeof(params), "case=yield mode=round_robin runnable=%d", runnable);
+        report(params, n);
+        if (runnable >= MAX_TASKS || task_create("spinner", spinner_task, NULL) < 0) {
+            break;
+        }
+        g_spinners++;
+    }
+    g_spin_stop = 1;
+    while (g_spinners > 0) {
+        task_yield();
+    }
+}
+
+// Lazy FPU switching: a yield round trip with one FPU-using task in the
+// rotation (TS is toggled, nothing traps), then with the caller using the
+// FPU as well (each side traps once per turn and the state is swapped).
+static void run_fpu_yields(uint32_t n) {
+    char params[48];
+    if (!fpu_sse_enabled()) {
+        return;
+    }
+    g_spin_stop = 0;
+    g_spinners = 0;
+    if (task_create("fpuspin", fpu_spinner_task, NULL) < 0) {
+        return;
+    }
+    g_spinners++;
+    int runnable = count_runnable();
+    sample_yields(n, 0, 0);
+    ksnprintf(params, sizeof(params), "case=yield mode=fpu_peer runnable=%d", runnable);
+    report(params, n);
+    sample_yields(n, 0, 1);
+    ksnprintf(params, sizeof(params), "case=yield mode=fpu_both runnable=%d", runnable);
+    report(params, n);
+
+    g_spin_stop = 1;
+    while (g_spinners > 0) {
+        task_yield();
+    }
+}
+
+int bench_sched(uint32_t n) {
+    if (n > BENCH_MAX_SAMPLES) {
+        n = BENCH_MAX_SAMPLES;
+    }
+    if (n < 2) {
+        n = 2;
+    }
+    if (task_get_current() < 0) {
+        kprintf("bench sched: must run in a task\n");
+        return -1;
+    }
+
+    bench_begin("sched", BENCH_SCHED_VERSION);
+    run_ctx_switch(n);
+
+    // Hinted back to ourselves: task -> scheduler_run -> same task.
+    sample_yields(n, 1, 0);
+    report("case=yield mode=self runnable=1", n);
+
+    int rc = run_create_restart(n);
+    if (rc != 0) {
+        kprintf("bench sched: no free task slot\n");
+    }
+    run_yield_sweep(n);
+    run_fpu_yields(n);
+    bench_end("sched");
+    return rc;
+}
@@ -0,0 +1,28 @@
+#include "kernel/boottime.h"
+
+#include <stddef.h>
+
+#include "kernel/timing.h"
+
+static boot_phase_t g_phases[BOOT_MAX_PHASES];
+static uint32_t g_count;
+
+void boot_mark(const char *name) {
+    if (g_count < BOOT_MAX_PHASES) {
+        g_phases[g_count].name = name;
+        g_phases[g_count].tsc = tsc_read();
+        g_count++;
+    }
+}
+
+uint32_t boot_phase_count(void) {
+    return g_count;
+}
+
+const boot_phase_t *boot_phase_get(uint32_t index) {
+    return index < g_count ? &g_phases[index] : NULL;
+}
+
+uint64_t boot_origin(void) {
+    return g_count ? g_phases[0].tsc : 0;
+}
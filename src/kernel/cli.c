@@ -6,15 +6,30 @@
 
 #include "kernel/serial.h"
 #include "kernel/vga.h"
+#include "kernel/bench.h"
+#include "kernel/boottime.h"
 #include "kernel/ipc.h"
+#include "kernel/fpu.h"
+#include "kernel/grant.h"
 #include "kernel/service_registry.h"
 #include "kernel/util.h"
 #include "kernel/timing.h"
+#include "kernel/klog.h"
+#include "kernel/kmem.h"
+#include "kernel/kprintf.h"
+#include "kernel/kstack.h"
+#include "kernel/paging.h"
+#include "kernel/prof.h"
+#include "kernel/syscall.h"
 #include "kernel/task.h"
+#include "kernel/trace.h"
+#include "services/block_service.h"
 #include "services/console_service.h"
 #include "services/echo_service.h"
+#include "services/fs_service.h"
 #include "services/timer_service.h"
 #include "services/monitor_service.h"
+#include "user/user_tasks.h"
 
 static void puts_both(const char *s) {
     vga_puts(s);
@@ -59,8 +74,24 @@ static void cmd_help(void) {
     puts_both("  log <text>   Send log message to console service\n");
     puts_both("  ipcecho <text> Send echo request via IPC\n");
     puts_both("  timertick    Trigger timer tick\n");
-    puts_both("  bench [n]    Benchmark direct vs IPC\n");
+    puts_both("  bench [n]    Benchmark direct vs IPC (with/without isolation)\n");
+    puts_both("  bench log [n] Console log throughput, old vs burst/coalesced\n");
+    puts_both("  bench fmt [n] Integer formatting, uint_to_str vs ksnprintf\n");
+    puts_both("  bench echo [n] Pipelined echo load across replicas\n");
+    puts_both("  bench block [n] RAM disk reads: random/sequential, cache hits\n");
+    puts_both("  bench ipc [n] IPC latency percentiles (@bench lines on serial)\n");
+    puts_both("  bench ops [n] Echo/timer/log cost per op (compare MODE=monolithic)\n");
+    puts_both("  bench sched [n] Context switch, yield, task create/restart cycles\n");
+    puts_both("  bench mem [n] kmemcpy/kmemset/kmemcmp per size class vs byte loops\n");
     puts_both("  crash        Crash echo service (fault isolation demo)\n");
+    puts_both("  hang         Hang echo service (heartbeat demo)\n");
+    puts_both("  cat <path>   Print a file from the initrd (fs service)\n");
+    puts_both("  stat <path>  Show size and mode of an initrd file\n");
+    puts_both("  boottime     Boot phase timeline and time to first prompt\n");
+    puts_both("  trace on|off|clear|dump Tracepoints; dump streams to serial\n");
+    puts_both("  mem          Show task stack usage and memory pools\n");
+    puts_both("  prof start [n] Sample EIP/task every n-th timer tick (1 kHz)\n");
+    puts_both("  prof stop|dump Stop, or stop and dump samples to serial\n");
     puts_both("  halt         Halt CPU\n");
 }
 
@@ -71,6 +102,7 @@ static void cmd_about(void) {
 
 static void cmd_halt(void) {
     puts_both("Halting...\n");
+    serial_flush();
     for (;;) {
         __asm__ volatile ("cli; hlt");
     }
@@ -80,12 +112,92 @@ static void cmd_services(void) {
     service_list_all();
 }
 
+// Yields to wait for the console to hand a log grant back.
+#define CLI_GRANT_IDLE_LIMIT 100000u
+
+// Text that does not fit one message is shared with the console by grant:
+// one page, mapped read-only on the console side, returned with MSG_GRANT_DONE.
+static void cmd_log_bulk(endpoint_id_t console_ep, const char *text, size_t len) {
+    static char *buf = NULL;
+    static endpoint_id_t log_ep = ENDPOINT_INVALID;
+    if (buf == NULL) {
+        buf = grant_buffer_alloc(1, 0);
+    }
+    if (log_ep == ENDPOINT_INVALID) {
+        log_ep = ipc_endpoint_create();
+    }
+    if (buf == NULL || log_ep == ENDPOINT_INVALID) {
+        puts_both("Error: no buffer for bulk log\n");
+        return;
+    }
+
+    kmemcpy(buf, text, len);
+
+    grant_id_t id = grant_create(buf, 1, console_ep, GRANT_READ);
+    if (id == GRANT_INVALID) {
+        puts_both("Error: failed to grant log buffer\n");
+        return;
+    }
+
+    ipc_msg_t msg;
+    msg.type = MSG_LOG_BULK;
+    msg.sender = log_ep;
+    msg.payload_len = sizeof(grant_ref_t);
+    grant_ref_t *ref = (grant_ref_t *)msg.payload;
+    ref->id = id;
+    ref->offset = 0;
+    ref->length = (uint32_t)len;
+
+    // Answers to an earlier request that timed out must not end this wait.
+    ipc_msg_t reply;
+    while (ipc_recv(log_ep, &reply) == IPC_SUCCESS) {
+    }
+    if (ipc_send(console_ep, &msg) != IPC_SUCCESS) {
+        (void)grant_revoke(id);
+        puts_both("Error: failed to send log message\n");
+        return;
+    }
+
+    // The buffer is reused, so wait until the console has let go of it. If it
+    // never answers, revoking the grant takes the pages back anyway.
+    const grant_done_t *done = (const grant_done_t *)reply.payload;
+    int status = -1;
+    for (uint32_t idle = 0; idle < CLI_GRANT_IDLE_LIMIT; idle++) {
+        if (ipc_recv(log_ep, &reply) == IPC_SUCCESS && reply.type == MSG_GRANT_DONE &&
+            reply.payload_len >= sizeof(grant_done_t) && done->id == id) {
+            status = done->status;
+            break;
+        }
+        task_yield();
+    }
+    (void)grant_revoke(id);
+    puts_both(status == 0 ? "Log message sent via grant\n" : "Error: console did not take the log grant\n");
+}
+
+// Resolved once; the registry keeps cached handles valid across rebinds.
+static service_handle_t g_console_handle = SERVICE_HANDLE_INVALID;
+static service_handle_t g_echo_handle = SERVICE_HANDLE_INVALID;
+
+static endpoint_id_t console_endpoint(void) {
+    return service_handle_lookup(&g_console_handle, CONSOLE_SERVICE_NAME, NULL);
+}
+
+static endpoint_id_t echo_endpoint(void) {
+    return service_handle_lookup(&g_echo_handle, ECHO_SERVICE_NAME, NULL);
+}
+
 static void cmd_log(const char *text) {
-    endpoint_id_t console_ep = service_lookup(CONSOLE_SERVICE_NAME);
+    endpoint_id_t console_ep = console_endpoint();
     if (console_ep == ENDPOINT_INVALID) {
         puts_both("Error: console service not found\n");
         return;
     }
+
+    size_t text_len = str_len(text);
+    if (text_len >= IPC_MAX_PAYLOAD) {
+        cmd_log_bulk(console_ep, text, text_len);
+        return;
+    }
     
     // Create and send log message
     ipc_msg_t msg;
@@ -109,8 +221,96 @@ static void cmd_log(const char *text) {
     }
 }
 
+static service_handle_t g_fs_handle = SERVICE_HANDLE_INVALID;
+static endpoint_id_t g_fs_reply_ep = ENDPOINT_INVALID;
+
+// Yields to wait for an fs reply before giving up on the request.
+#define CLI_FS_IDLE_LIMIT 100000u
+
+// One request to the fs service; waits for the reply. Returns its status, or
+// -1 if the service did not answer in time.
+static int fs_call(msg_type_t type, const void *payload, uint32_t len, fs_reply_t *out) {
+    if (g_fs_reply_ep == ENDPOINT_INVALID) {
+        g_fs_reply_ep = ipc_endpoint_create();
+    }
+    endpoint_id_t fs_ep = service_handle_lookup(&g_fs_handle, FS_SERVICE_NAME, NULL);
+    if (fs_ep == ENDPOINT_INVALID || g_fs_reply_ep == ENDPOINT_INVALID || len > IPC_MAX_PAYLOAD) {
+        return -1;
+    }
+
+    ipc_msg_t msg;
+    msg.type = type;
+    msg.sender = g_fs_reply_ep;
+    msg.payload_len = len;
+    kmemcpy(msg.payload, payload, len);
+    // A late reply to a request that timed out must not answer this one.
+    ipc_msg_t reply;
+    while (ipc_recv(g_fs_reply_ep, &reply) == IPC_SUCCESS) {
+    }
+    if (ipc_send(fs_ep, &msg) != IPC_SUCCESS) {
+        return -1;
+    }
+    for (uint32_t idle = 0; idle < CLI_FS_IDLE_LIMIT; idle++) {
+        if (ipc_recv(g_fs_reply_ep, &reply) == IPC_SUCCESS && reply.type == MSG_FS_REPLY) {
+            *out = *(const fs_reply_t *)reply.payload;
+            return out->status;
+        }
+        task_yield();
+    }
+    return -1;
+}
+
+static void cmd_stat(const char *path) {
+    fs_reply_t r;
+    if (fs_call(MSG_FS_STAT, path, (uint32_t)str_len(path) + 1u, &r) != 0) {
+        kprintf("stat: %s: not found\n", path);
+        return;
+    }
+    kprintf("%s: %u bytes, mode %u%u%u\n", path, r.size, (r.mode >> 6) & 7u, (r.mode >> 3) & 7u, r.mode & 7u);
+}
+
+// cat <path>: the file is printed straight out of the archive pages the fs
+// service lends us; nothing is copied through messages.
+static void cmd_cat(const char *path) {
+    fs_reply_t r;
+    if (fs_call(MSG_FS_OPEN, path, (uint32_t)str_len(path) + 1u, &r) != 0) {
+        kprintf("cat: %s: not found\n", path);
+        return;
+    }
+    fs_read_req_t req = { r.fd, 0, 0xFFFFFFFFu };
+    while (req.offset < r.size) {
+        fs_reply_t chunk;
+        const char *base = NULL;
+        if (fs_call(MSG_FS_READ, &req, sizeof(req), &chunk) != 0 || chunk.data.length == 0) {
+            kprintf("cat: %s: read failed at %u\n", path, req.offset);
+            return;
+        }
+        int mapped = grant_map(chunk.data.id, g_fs_reply_ep, GRANT_READ, 0, (void **)&base) == 0;
+        if (mapped) {
+            vga_write(base + chunk.data.offset, chunk.data.length);
+            serial_write_len(base + chunk.data.offset, chunk.data.length);
+            (void)grant_unmap(chunk.data.id);
+        }
+
+        // Hand the loan back even if it could not be used.
+        ipc_msg_t done;
+        done.type = MSG_GRANT_DONE;
+        done.sender = g_fs_reply_ep;
+        done.payload_len = sizeof(grant_done_t);
+        grant_done_t *d = (grant_done_t *)done.payload;
+        d->id = chunk.data.id;
+        d->status = mapped ? 0 : -1;
+        (void)ipc_send(service_handle_lookup(&g_fs_handle, FS_SERVICE_NAME, NULL), &done);
+        if (!mapped) {
+            kprintf("cat: %s: read failed at %u\n", path, req.offset);
+            return;
+        }
+        req.offset += chunk.data.length;
+    }
+}
+
 static void cmd_ipcecho(const char *text) {
-    endpoint_id_t echo_ep = service_lookup(ECHO_SERVICE_NAME);
+    endpoint_id_t echo_ep = echo_endpoint();
     if (echo_ep == ENDPOINT_INVALID) {
         puts_both("Error: echo service not found\n");
         return;
@@ -197,17 +397,120 @@ static uint32_t parse_u32_or_default(const char *s, uint32_t def) {
     return any ? v : def;
 }
 
-static void print_tsc_delta(const char *label, tsc_t d) {
-    char hi[9];
-    char lo[9];
-    u32_to_hex(d.hi, hi, sizeof(hi));
-    u32_to_hex(d.lo, lo, sizeof(lo));
+// Per-op time to a tenth of a nanosecond, with the raw cycle count alongside.
+static void print_tsc_per_op(const char *label, tsc_t d, uint32_t n) {
+    if (n == 0) {
+        n = 1;
+    }
+    uint64_t cycles = tsc_to_u64(d);
+    uint32_t tenth;
+    uint64_t ns = u64_div_u32(u64_div_u32(clock_cycles_to_ns(cycles) * 10u, n, NULL), 10u, &tenth);
+    kprintf("%s%llu.%u ns (%llu cycles)\n", label, ns, tenth, u64_div_u32(cycles, n, NULL));
+}
+
+// n lock-step round trips client -> echo service -> client.
+// Returns 0 on success, -1 if a send or reply failed.
+static int bench_ipc_round_trips(endpoint_id_t echo_ep, endpoint_id_t cli_ep, const ipc_msg_t *msg,
+                                 uint32_t n, tsc_t *out) {
+    tsc_t t0 = tsc_bench_start();
+    for (uint32_t i = 0; i < n; i++) {
+        if (ipc_send(echo_ep, msg) != IPC_SUCCESS) {
+            puts_both("bench: ipc_send failed\n");
+            return -1;
+        }
 
-    puts_both(label);
-    puts_both("0x");
-    puts_both(hi);
-    puts_both(lo);
-    puts_both("\n");
+        ipc_msg_t reply;
+        for (;;) {
+            if (ipc_recv(cli_ep, &reply) == IPC_SUCCESS) {
+                break;
+            }
+            task_yield();
+        }
+        if (reply.type != MSG_ECHO_REPLY) {
+            puts_both("bench: missing/invalid reply\n");
+            return -1;
+        }
+    }
+    tsc_t t1 = tsc_bench_stop();
+    *out = tsc_sub(t1, t0);
+    return 0;
+}
+
+// Yields to wait for the sysbench task's reply; it also stops early if the
+// task is gone (faulted or exited without answering).
+#define CLI_SYSBENCH_IDLE_LIMIT 100000u
+
+// Times SYS_NULL from ring 3 through the int 0x80 gate and through SYSENTER.
+// The work runs in a short-lived user task; results come back over IPC.
+static void bench_syscall_paths(uint32_t n, endpoint_id_t cli_ep) {
+    static endpoint_id_t req_ep = ENDPOINT_INVALID;
+    if (req_ep == ENDPOINT_INVALID) {
+        req_ep = ipc_endpoint_create();
+        if (req_ep == ENDPOINT_INVALID) {
+            puts_both("bench: failed to create syscall bench endpoint\n");
+            return;
+        }
+    }
+
+    ipc_msg_t req;
+    req.type = MSG_SYSCALL_BENCH;
+    req.sender = cli_ep;
+    req.payload_len = sizeof(uint32_t);
+    *((uint32_t *)req.payload) = n;
+    if (ipc_send(req_ep, &req) != IPC_SUCCESS) {
+        puts_both("bench: failed to queue syscall bench request\n");
+        return;
+    }
+
+    task_attr_t user = { .flags = TASK_FLAG_USER, .stack_size = 2048 };
+    int tid = task_create_ex("sysbench", syscall_bench_user_main, (void *)(uintptr_t)req_ep, &user);
+    if (tid < 0) {
+        ipc_msg_t stale;
+        (void)ipc_recv(req_ep, &stale);
+        puts_both("bench: no task slot for syscall bench\n");
+        return;
+    }
+    ipc_endpoint_set_owner(req_ep, tid);
+
+    ipc_msg_t reply;
+    int got = 0;
+    int gone = 0;
+    for (uint32_t idle = 0; idle < CLI_SYSBENCH_IDLE_LIMIT; idle++) {
+        if (ipc_recv(cli_ep, &reply) == IPC_SUCCESS) {
+            got = 1;
+            break;
+        }
+        task_info_t info;
+        if (task_get_info(tid, &info) != 0 || !info.running) {
+            // It may have replied just before finishing.
+            got = ipc_recv(cli_ep, &reply) == IPC_SUCCESS;
+            gone = 1;
+            break;
+        }
+        task_yield();
+    }
+    if (!got) {
+        if (!gone) {
+            (void)task_kill(tid);
+        }
+        // Drop a request the task never took, so the next run starts clean.
+        ipc_msg_t stale;
+        while (ipc_recv(req_ep, &stale) == IPC_SUCCESS) {
+        }
+        puts_both(gone ? "bench: syscall bench task exited without replying\n"
+                       : "bench: syscall bench task did not reply\n");
+        return;
+    }
+    if (reply.type != MSG_SYSCALL_BENCH || reply.payload_len < 4 * sizeof(uint32_t)) {
+        puts_both("bench: invalid syscall bench reply\n");
+        return;
+    }
+
+    const uint32_t *words = (const uint32_t *)reply.payload;
+    tsc_t d_int = { words[0], words[1] };
+    tsc_t d_sysenter = { words[2], words[3] };
+    print_tsc_per_op("bench: syscall via int 0x80 = ", d_int, n);
+    print_tsc_per_op("bench: syscall via sysenter = ", d_sysenter, n);
 }
 
 static void direct_echo_copy(const uint8_t *in, uint32_t len, uint8_t *out) {
@@ -217,18 +520,408 @@ static void direct_echo_copy(const uint8_t *in, uint32_t len, uint8_t *out) {
     if (len > IPC_MAX_PAYLOAD) {
         len = IPC_MAX_PAYLOAD;
     }
-    for (uint32_t i = 0; i < len; i++) {
-        out[i] = in[i];
+    kmemcpy(out, in, len);
+}
+
+// Sends n MSG_LOG lines to the console (yielding whenever its queue is full)
+// and waits until the console has drained and flushed them all.
+static void bench_log_lines(endpoint_id_t console_ep, uint32_t n, tsc_t *out) {
+    static const char line[] = "bench log line: the quick brown fox jumps";
+
+    ipc_msg_t msg;
+    msg.type = MSG_LOG;
+    msg.sender = ENDPOINT_INVALID;
+    msg.payload_len = sizeof(line) - 1;
+    kmemcpy(msg.payload, line, sizeof(line));
+
+    tsc_t t0 = tsc_bench_start();
+    uint32_t sent = 0;
+    while (sent < n) {
+        if (ipc_send(console_ep, &msg) == IPC_SUCCESS) {
+            sent++;
+            continue;
+        }
+        task_yield();
+    }
+    while (ipc_has_messages(console_ep)) {
+        task_yield();
+    }
+    tsc_t t1 = tsc_bench_stop();
+    *out = tsc_sub(t1, t0);
+}
+
+// Records n klog lines in batches that fit the CLI's ring, letting the console
+// render each batch; only the recording is timed.
+static void bench_klog_records(uint32_t n, tsc_t *out) {
+    tsc_t total = { 0, 0 };
+    uint32_t i = 0;
+    while (i < n) {
+        uint32_t batch = n - i;
+        if (batch > KLOG_RING_ENTRIES / 2) {
+            batch = KLOG_RING_ENTRIES / 2;
+        }
+        tsc_t t0 = tsc_bench_start();
+        for (uint32_t j = 0; j < batch; j++) {
+            klog(KLOG_INFO, "bench klog: record %u of %u", i + j + 1, n);
+        }
+        tsc_t d = tsc_sub(tsc_bench_stop(), t0);
+        uint32_t lo = total.lo + d.lo;
+        total.hi += d.hi + (lo < total.lo ? 1u : 0u);
+        total.lo = lo;
+        i += batch;
+        while (klog_pending() != 0) {
+            task_yield();
+        }
     }
+    *out = total;
+}
+
+// bench log [n]: log throughput with per-byte UART polling and per-fragment
+// console writes (the old path) vs. FIFO bursts and one flush per pass, both
+// polled, vs. the same through the interrupt-driven transmit ring.
+static void cmd_bench_log(const char *args) {
+    uint32_t n = parse_u32_or_default(args, 64u);
+    if (n == 0) {
+        n = 1;
+    }
+
+    endpoint_id_t console_ep = console_endpoint();
+    if (console_ep == ENDPOINT_INVALID) {
+        puts_both("bench: console service not found\n");
+        return;
+    }
+
+    tsc_t d_before;
+    tsc_t d_after;
+    tsc_t d_async;
+    uint32_t dropped_before;
+    uint32_t dropped_after;
+    serial_set_async(0);
+    serial_set_fifo_burst(0);
+    console_service_set_coalesce(0);
+    bench_log_lines(console_ep, n, &d_before);
+    serial_set_fifo_burst(1);
+    console_service_set_coalesce(1);
+    bench_log_lines(console_ep, n, &d_after);
+    serial_set_async(1);
+    serial_tx_stats(NULL, &dropped_before);
+    bench_log_lines(console_ep, n, &d_async);
+    serial_tx_stats(NULL, &dropped_after);
+
+    kprintf("bench log: lines=%u\n", n);
+    print_tsc_per_op("bench log: per-byte, per-fragment = ", d_before, n);
+    print_tsc_per_op("bench log: fifo burst, coalesced  = ", d_after, n);
+    print_tsc_per_op("bench log: irq-driven tx ring     = ", d_async, n);
+    kprintf("bench log: tx ring dropped %u bytes\n", dropped_after - dropped_before);
+    if (d_before.hi == 0 && d_after.hi == 0 && d_after.lo != 0) {
+        kprintf("bench log: speedup x%u.%u\n", d_before.lo / d_after.lo,
+                (d_before.lo % d_after.lo) * 10u / d_after.lo);
+    }
+
+    tsc_t d_klog;
+    bench_klog_records(n, &d_klog);
+    print_tsc_per_op("bench log: klog record (deferred) = ", d_klog, n);
+    klog_stats_t ks;
+    klog_get_stats(&ks);
+    kprintf("bench log: klog written=%u dropped=%u shed=%u\n", ks.written, ks.dropped, ks.shed);
+}
+
+// bench fmt [n]: integer formatting, the old helpers vs ksnprintf.
+static void cmd_bench_fmt(const char *args) {
+    uint32_t n = parse_u32_or_default(args, 10000u);
+    if (n == 0) {
+        n = 1;
+    }
+
+    // Spread values over every digit count; the sink keeps the work live.
+    char buf[24];
+    volatile char sink = 0;
+    tsc_t t0 = tsc_bench_start();
+    for (uint32_t i = 0; i < n; i++) {
+        uint_to_str(i * 2654435761u, buf, sizeof(buf));
+        sink = buf[0];
+    }
+    tsc_t d_old_dec = tsc_sub(tsc_bench_stop(), t0);
+
+    t0 = tsc_bench_start();
+    for (uint32_t i = 0; i < n; i++) {
+        ksnprintf(buf, sizeof(buf), "%u", i * 2654435761u);
+        sink = buf[0];
+    }
+    tsc_t d_new_dec = tsc_sub(tsc_bench_stop(), t0);
+
+    t0 = tsc_bench_start();
+    for (uint32_t i = 0; i < n; i++) {
+        u32_to_hex(i * 2654435761u, buf, sizeof(buf));
+        sink = buf[0];
+    }
+    tsc_t d_old_hex = tsc_sub(tsc_bench_stop(), t0);
+
+    t0 = tsc_bench_start();
+    for (uint32_t i = 0; i < n; i++) {
+        ksnprintf(buf, sizeof(buf), "%08X", i * 2654435761u);
+        sink = buf[0];
+    }
+    tsc_t d_new_hex = tsc_sub(tsc_bench_stop(), t0);
+
+    t0 = tsc_bench_start();
+    for (uint32_t i = 0; i < n; i++) {
+        ksnprintf(buf, sizeof(buf), "%llu", ((uint64_t)i << 32) | (i * 2654435761u));
+        sink = buf[0];
+    }
+    tsc_t d_new_u64 = tsc_sub(tsc_bench_stop(), t0);
+    (void)sink;
+
+    kprintf("bench fmt: iterations=%u\n", n);
+    print_tsc_per_op("bench fmt: uint_to_str       = ", d_old_dec, n);
+    print_tsc_per_op("bench fmt: ksnprintf %u      = ", d_new_dec, n);
+    print_tsc_per_op("bench fmt: u32_to_hex        = ", d_old_hex, n);
+    print_tsc_per_op("bench fmt: ksnprintf %08X    = ", d_new_hex, n);
+    print_tsc_per_op("bench fmt: ksnprintf %llu    = ", d_new_u64, n);
+}
+
+// bench echo [n]: n pipelined echo requests, each sent to whatever instance
+// the registry picks, so the monitor may add replicas while it runs.
+static void cmd_bench_echo(const char *args) {
+    uint32_t n = parse_u32_or_default(args, 4000u);
+    if (n == 0) {
+        n = 1;
+    }
+
+    static endpoint_id_t reply_ep = ENDPOINT_INVALID;
+    if (reply_ep == ENDPOINT_INVALID) {
+        reply_ep = ipc_endpoint_create();
+        if (reply_ep == ENDPOINT_INVALID) {
+            puts_both("bench: failed to create client endpoint\n");
+            return;
+        }
+    }
+
+    ipc_msg_t msg;
+    msg.type = MSG_ECHO;
+    msg.sender = reply_ep;
+    msg.payload_len = 8;
+    for (uint32_t i = 0; i < msg.payload_len; i++) {
+        msg.payload[i] = (uint8_t)('a' + i);
+    }
+
+    int peak_instances = service_instance_count(ECHO_SERVICE_NAME);
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t stalls = 0;
+    uint32_t idle_yields = 0;
+    tsc_t t0 = tsc_bench_start();
+    while (received < n) {
+        ipc_msg_t reply;
+        while (ipc_recv(reply_ep, &reply) == IPC_SUCCESS) {
+            received++;
+            idle_yields = 0;
+        }
+        // Requests queued on a replica that died are gone; do not wait forever.
+        if (++idle_yields > 100000u) {
+            kprintf("bench echo: gave up after %u of %u replies\n", received, n);
+            return;
+        }
+        // Keep the reply queue from overflowing: at most IPC_QUEUE_SIZE in flight.
+        if (sent < n && sent - received < IPC_QUEUE_SIZE) {
+            endpoint_id_t ep = echo_endpoint();
+            if (ep != ENDPOINT_INVALID && ipc_send(ep, &msg) == IPC_SUCCESS) {
+                sent++;
+                continue;
+            }
+            stalls++;
+        }
+        int instances = service_instance_count(ECHO_SERVICE_NAME);
+        if (instances > peak_instances) {
+            peak_instances = instances;
+        }
+        task_yield();
+    }
+    tsc_t d = tsc_sub(tsc_bench_stop(), t0);
+
+    kprintf("bench echo: requests=%u instances peak=%d now=%d send stalls=%u\n", n, peak_instances,
+            service_instance_count(ECHO_SERVICE_NAME), stalls);
+    print_tsc_per_op("bench echo: per request = ", d, n);
+}
+
+// Client buffer for `bench block`, granted to the block service read/write.
+#define BLOCK_BENCH_PAGES 2u
+#define BLOCK_BENCH_SEQ_BLOCKS 8u
+
+typedef struct {
+    endpoint_id_t block_ep;
+    endpoint_id_t reply_ep;
+    grant_id_t grant;
+    uint32_t disk_blocks;
+} block_bench_t;
+
+// One arm on a cold cache: n requests of per_req blocks, up to depth in
+// flight, at random or ascending LBAs. Returns -1 if replies stop coming.
+static int block_bench_arm(const block_bench_t *b, const char *label, uint32_t n, uint32_t depth,
+                           uint32_t per_req, int sequential) {
+    block_service_reset();
+    uint32_t span = b->disk_blocks / per_req * per_req;
+    uint32_t seed = 0x2545F491u;
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t failed = 0;
+    uint32_t idle_yields = 0;
+
+    tsc_t t0 = tsc_bench_start();
+    while (received < n) {
+        ipc_msg_t reply;
+        while (ipc_recv(b->reply_ep, &reply) == IPC_SUCCESS) {
+            if (reply.type != MSG_BLOCK_REPLY) {
+                continue;
+            }
+            if (((const block_reply_t *)reply.payload)->status != 0) {
+                failed++;
+            }
+            received++;
+            idle_yields = 0;
+        }
+        if (++idle_yields > 100000u) {
+            kprintf("bench block: gave up after %u of %u replies\n", received, n);
+            return -1;
+        }
+        if (sent < n && sent - received < depth) {
+            uint32_t lba;
+            if (sequential) {
+                lba = (sent * per_req) % span;
+            } else {
+                seed = seed * 1664525u + 1013904223u;
+                lba = (seed >> 8) % span;
+            }
+            ipc_msg_t msg;
+            msg.type = MSG_BLOCK_READ;
+            msg.sender = b->reply_ep;
+            msg.payload_len = sizeof(block_req_t);
+            block_req_t *req = (block_req_t *)msg.payload;
+            req->grant = b->grant;
+            req->offset = (sent % depth) * per_req * BLOCK_SIZE;
+            req->lba = lba;
+            req->count = per_req;
+            req->tag = sent;
+            if (ipc_send(b->block_ep, &msg) == IPC_SUCCESS) {
+                sent++;
+                continue;
+            }
+        }
+        task_yield();
+    }
+    tsc_t d = tsc_sub(tsc_bench_stop(), t0);
+
+    block_stats_t st;
+    block_service_get_stats(&st);
+    uint64_t us = u64_div_u32(clock_cycles_to_ns(tsc_to_u64(d)), 1000u, NULL);
+    uint64_t bytes = (uint64_t)n * per_req * BLOCK_SIZE;
+    uint32_t lookups = st.hits + st.misses;
+    kprintf("bench block: %-24s %6llu MB/s  hit %3u%%  ra %u/%u  dev ops %u  batches %u%s\n", label,
+            us ? u64_div_u32(bytes, us > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)us, NULL) : 0ull,
+            lookups ? st.hits * 100u / lookups : 0u, st.readahead_hits, st.readahead, st.device_ops, st.batches,
+            failed ? "  (errors)" : "");
+    return 0;
+}
+
+// bench block [n]: read throughput and cache behaviour of the block service.
+static void cmd_bench_block(const char *args) {
+    uint32_t n = parse_u32_or_default(args, 2000u);
+    if (n == 0) {
+        n = 1;
+    }
+
+    static block_bench_t b = { ENDPOINT_INVALID, ENDPOINT_INVALID, GRANT_INVALID, 0 };
+    static void *buf = NULL;
+    b.block_ep = block_service_get_endpoint();
+    b.disk_blocks = block_service_block_count();
+    if (b.block_ep == ENDPOINT_INVALID || b.disk_blocks < BLOCK_BENCH_SEQ_BLOCKS) {
+        puts_both("bench block: no disk (boot with the ramdisk module)\n");
+        return;
+    }
+    if (buf == NULL) {
+        buf = grant_buffer_alloc(BLOCK_BENCH_PAGES, 0);
+    }
+    if (b.reply_ep == ENDPOINT_INVALID) {
+        b.reply_ep = ipc_endpoint_create();
+    }
+    if (buf == NULL || b.reply_ep == ENDPOINT_INVALID) {
+        puts_both("bench block: no client buffer\n");
+        return;
+    }
+    b.grant = grant_create(buf, BLOCK_BENCH_PAGES, b.block_ep, GRANT_READ | GRANT_WRITE);
+    if (b.grant == GRANT_INVALID) {
+        puts_both("bench block: failed to grant buffer\n");
+        return;
+    }
+
+    kprintf("bench block: requests=%u disk=%u blocks\n", n, b.disk_blocks);
+    int rc = block_bench_arm(&b, "random, 1 in flight", n, 1, 1, 0);
+    if (rc == 0) {
+        rc = block_bench_arm(&b, "random, batched", n, IPC_QUEUE_SIZE, 1, 0);
+    }
+    if (rc == 0) {
+        uint32_t ra = block_service_set_readahead(0);
+        rc = block_bench_arm(&b, "sequential, no read-ahead", n, 1, BLOCK_BENCH_SEQ_BLOCKS, 1);
+        (void)block_service_set_readahead(ra);
+    }
+    if (rc == 0) {
+        (void)block_bench_arm(&b, "sequential, read-ahead", n, 1, BLOCK_BENCH_SEQ_BLOCKS, 1);
+    }
+    (void)grant_revoke(b.grant);
+    b.grant = GRANT_INVALID;
+}
+
+static int bench_sub_is(const char *args, const char *name) {
+    size_t i = 0;
+    for (; name[i] != '\0'; i++) {
+        if (args[i] != name[i]) {
+            return 0;
+        }
+    }
+    return args[i] == '\0' || args[i] == ' ' || args[i] == '\t';
 }
 
 static void cmd_bench(const char *args) {
+    args = skip_spaces(args);
+    if (bench_sub_is(args, "log")) {
+        cmd_bench_log(args + 3);
+        return;
+    }
+    if (bench_sub_is(args, "echo")) {
+        cmd_bench_echo(args + 4);
+        return;
+    }
+    if (bench_sub_is(args, "block")) {
+        cmd_bench_block(args + 5);
+        return;
+    }
+    if (bench_sub_is(args, "fmt")) {
+        cmd_bench_fmt(args + 3);
+        return;
+    }
+    if (bench_sub_is(args, "ipc")) {
+        (void)bench_ipc(parse_u32_or_default(args + 3, 1000u));
+        return;
+    }
+    if (bench_sub_is(args, "mem")) {
+        (void)bench_mem(parse_u32_or_default(args + 3, 1000u));
+        return;
+    }
+    if (bench_sub_is(args, "ops")) {
+        (void)bench_ops(parse_u32_or_default(args + 3, 1000u));
+        return;
+    }
+    if (bench_sub_is(args, "sched")) {
+        (void)bench_sched(parse_u32_or_default(args + 5, 1000u));
+        return;
+    }
+
     uint32_t n = parse_u32_or_default(args, 2000u);
     if (n == 0) {
         n = 1;
     }
 
-    endpoint_id_t echo_ep = service_lookup(ECHO_SERVICE_NAME);
+    endpoint_id_t echo_ep = echo_endpoint();
     if (echo_ep == ENDPOINT_INVALID) {
         puts_both("bench: echo service not found\n");
         return;
@@ -252,18 +945,14 @@ static void cmd_bench(const char *args) {
 
     uint32_t payload_len = 32;
 
-    puts_both("bench: iterations=");
-    char nbuf[16];
-    uint_to_str(n, nbuf, sizeof(nbuf));
-    puts_both(nbuf);
-    puts_both("\n");
+    kprintf("bench: iterations=%u\n", n);
 
     // Direct-call benchmark
-    tsc_t t0 = tsc_now();
+    tsc_t t0 = tsc_bench_start();
     for (uint32_t i = 0; i < n; i++) {
         direct_echo_copy(payload, payload_len, out);
     }
-    tsc_t t1 = tsc_now();
+    tsc_t t1 = tsc_bench_stop();
     tsc_t d_direct = tsc_sub(t1, t0);
 
     // IPC benchmark (client -> echo service -> client)
@@ -271,41 +960,165 @@ static void cmd_bench(const char *args) {
     msg.type = MSG_ECHO;
     msg.sender = cli_ep;
     msg.payload_len = payload_len;
-    for (uint32_t i = 0; i < payload_len; i++) {
-        msg.payload[i] = payload[i];
+    kmemcpy(msg.payload, payload, payload_len);
+
+    // Run the IPC loop on per-service page directories, then with every task on
+    // the kernel space, so the difference is the per-round-trip isolation cost.
+    int was_isolated = paging_isolation_enabled();
+    tsc_t d_ipc;
+    tsc_t d_ipc_flat;
+    paging_set_isolation(1);
+    int rc = bench_ipc_round_trips(echo_ep, cli_ep, &msg, n, &d_ipc);
+    paging_set_isolation(0);
+    if (rc == 0) {
+        rc = bench_ipc_round_trips(echo_ep, cli_ep, &msg, n, &d_ipc_flat);
+    }
+    paging_set_isolation(was_isolated);
+    if (rc != 0) {
+        return;
     }
 
-    tsc_t t2 = tsc_now();
-    for (uint32_t i = 0; i < n; i++) {
-        if (ipc_send(echo_ep, &msg) != IPC_SUCCESS) {
-            puts_both("bench: ipc_send failed\n");
-            break;
-        }
+    kprintf("bench: tsc %u kHz (%s)\n", clock_tsc_khz(), clock_source());
+    print_tsc_per_op("bench: direct copy                = ", d_direct, n);
+    print_tsc_per_op("bench: ipc round trip, isolated   = ", d_ipc, n);
+    print_tsc_per_op("bench: ipc round trip, one space  = ", d_ipc_flat, n);
+    if (d_ipc.hi == 0 && d_ipc_flat.hi == 0 && d_ipc.lo >= d_ipc_flat.lo) {
+        tsc_t extra = tsc_sub(d_ipc, d_ipc_flat);
+        print_tsc_per_op("bench: isolation cost/round trip = ", extra, n);
+    }
 
-        ipc_msg_t reply;
-        for (;;) {
-            if (ipc_recv(cli_ep, &reply) == IPC_SUCCESS) {
-                break;
-            }
-            task_yield();
-        }
-        if (reply.type != MSG_ECHO_REPLY) {
-            puts_both("bench: missing/invalid reply\n");
-            break;
+    if (syscall_fast_path_available()) {
+        bench_syscall_paths(n, cli_ep);
+    }
+}
+
+static void cmd_mem(void) {
+    puts_both("Task stacks (bytes):\n");
+    for (int i = 0; i < MAX_TASKS; i++) {
+        task_info_t info;
+        if (task_get_info(i, &info) != 0) {
+            continue;
         }
+        kprintf("  %-8s %-9s size=%5u peak=%5u%s\n", info.name ? info.name : "?",
+                info.running ? "" : "(stopped)", info.stack_size, info.stack_peak,
+                info.stack_overflow ? "  OVERFLOW" : "");
+    }
+
+    uint32_t used;
+    uint32_t free_bytes;
+    uint32_t largest;
+    kstack_stats(&used, &free_bytes, &largest);
+    kprintf("Stack arena: used=%u free=%u largest_free=%u\n", used, free_bytes, largest);
+
+    uint32_t frames;
+    uint32_t total;
+    paging_pool_stats(&frames, &total);
+    kprintf("Page pool: %u/%u frames\n", frames, total);
+
+    uint32_t queued;
+    uint32_t dropped;
+    serial_tx_stats(&queued, &dropped);
+    kprintf("Serial TX ring: queued=%u/%u dropped=%u\n", queued, SERIAL_TX_RING_SIZE, dropped);
+
+    fpu_stats_t fpu;
+    fpu_get_stats(&fpu);
+    if (!fpu.enabled) {
+        puts_both("FPU: disabled (no FXSR/SSE)\n");
+    } else {
+        kprintf("FPU: owner=%d traps=%u saves=%u restores=%u\n", fpu.owner, fpu.traps, fpu.saves, fpu.restores);
+    }
+}
+
+static void print_ms(uint64_t cycles) {
+    uint32_t frac;
+    uint64_t ms = u64_div_u32(u64_div_u32(clock_cycles_to_ns(cycles), 1000u, NULL), 1000u, &frac);
+    kprintf("%6llu.%03u", ms, frac);
+}
+
+// boottime: every boot mark with its offset from kmain entry and how long
+// the phase before it took. Lazy service starts show up as they happen.
+static void cmd_boottime(void) {
+    uint32_t n = boot_phase_count();
+    if (n == 0) {
+        return;
+    }
+    uint64_t origin = boot_origin();
+    puts_both("TSC at kmain entry (firmware + loader): ");
+    print_ms(origin);
+    puts_both(" ms\n      at ms     took ms  phase\n");
+    for (uint32_t i = 0; i < n; i++) {
+        const boot_phase_t *p = boot_phase_get(i);
+        uint64_t prev = i ? boot_phase_get(i - 1)->tsc : origin;
+        puts_both("  ");
+        print_ms(p->tsc - origin);
+        puts_both("  ");
+        print_ms(p->tsc - prev);
+        kprintf("  %s\n", p->name);
+    }
+}
+
+static void cmd_prof(const char *args) {
+    args = skip_spaces(args);
+    if (bench_sub_is(args, "start")) {
+        uint32_t every = parse_u32_or_default(args + 5, 1u);
+        prof_start(every);
+        kprintf("prof: sampling every %u tick(s) at %u Hz, ring of %u\n", every ? every : 1u, PROF_TIMER_HZ,
+                PROF_RING_SIZE);
+        return;
+    }
+    if (bench_sub_is(args, "stop")) {
+        prof_stop();
+    } else if (bench_sub_is(args, "dump")) {
+        prof_dump();
+        puts_both("prof: samples written to serial (scripts/prof_symbolize.py)\n");
+    } else if (*args != '\0') {
+        puts_both("usage: prof start [n] | stop | dump\n");
+        return;
+    }
+    prof_stats_t st;
+    prof_get_stats(&st);
+    kprintf("prof: %s, ticks=%u samples=%u overwritten=%u\n", st.running ? "running" : "stopped", st.ticks,
+            st.samples, st.overwritten);
+}
+
+static void cmd_trace(const char *args) {
+    args = skip_spaces(args);
+    if (bench_sub_is(args, "on")) {
+        trace_set_enabled(1);
+    } else if (bench_sub_is(args, "off")) {
+        trace_set_enabled(0);
+    } else if (bench_sub_is(args, "clear")) {
+        trace_clear();
+    } else if (bench_sub_is(args, "dump")) {
+        trace_dump();
+        puts_both("trace: records written to serial (scripts/trace2chrome.py)\n");
+    } else if (*args != '\0') {
+        puts_both("usage: trace on | off | clear | dump\n");
+        return;
     }
-    tsc_t t3 = tsc_now();
-    tsc_t d_ipc = tsc_sub(t3, t2);
+    uint32_t records;
+    uint32_t overwritten;
+    trace_get_stats(&records, &overwritten);
+    kprintf("trace: %s, records=%u/%u overwritten=%u\n", trace_enabled ? "on" : "off", records, TRACE_RING_SIZE,
+            overwritten);
+}
 
-    print_tsc_delta("bench: direct cycles = ", d_direct);
-    print_tsc_delta("bench: ipc cycles    = ", d_ipc);
-    puts_both("bench: (counts are TSC delta; compare magnitudes)\n");
+#ifdef CONFIG_MONOLITHIC
+// Echo requests are direct calls here, so crash and hang would run in the
+// CLI's own context and take the shell down with them.
+static void cmd_crash(void) {
+    puts_both("Error: crash needs an isolated echo task (not in MODE=monolithic)\n");
 }
 
+static void cmd_hang(void) {
+    puts_both("Error: hang needs an isolated echo task (not in MODE=monolithic)\n");
+}
+#else
 static void cmd_crash(void) {
     puts_both("[CRASH DEMO] Sending crash message to echo service...\n");
     
-    endpoint_id_t echo_ep = service_lookup(ECHO_SERVICE_NAME);
+    // The primary instance: replicas are not restarted by the monitor.
+    endpoint_id_t echo_ep = echo_service_get_endpoint();
     if (echo_ep == ENDPOINT_INVALID) {
         puts_both("Error: echo service not found\n");
         return;
@@ -326,6 +1139,18 @@ static void cmd_crash(void) {
     puts_both("[CRASH DEMO] After a moment, try: ipcecho test\n");
 }
 
+static void cmd_hang(void) {
+    ipc_msg_t hang_msg;
+    hang_msg.type = MSG_HANG;
+    hang_msg.sender = ENDPOINT_INVALID;
+    hang_msg.payload_len = 0;
+    if (ipc_send(echo_service_get_endpoint(), &hang_msg) != IPC_SUCCESS) {
+        puts_both("Error: failed to send hang message\n");
+        return;
+    }
+    puts_both("[HANG DEMO] Echo now yields forever without heartbeats; the monitor should restart it.\n");
+}
+#endif
 
 static void exec_line(const char *line) {
     line = skip_spaces(line);
@@ -361,6 +1186,26 @@ static void exec_line(const char *line) {
         cmd_crash();
         return;
     }
+    if (str_eq(line, "hang")) {
+        cmd_hang();
+        return;
+    }
+    if (str_eq(line, "boottime")) {
+        cmd_boottime();
+        return;
+    }
+    if (bench_sub_is(line, "prof")) {
+        cmd_prof(line + 4);
+        return;
+    }
+    if (bench_sub_is(line, "trace")) {
+        cmd_trace(line + 5);
+        return;
+    }
+    if (str_eq(line, "mem")) {
+        cmd_mem();
+        return;
+    }
     if (str_eq(line, "halt")) {
         cmd_halt();
         return;
@@ -382,6 +1227,15 @@ static void exec_line(const char *line) {
         return;
     }
     
+    if (bench_sub_is(line, "cat")) {
+        cmd_cat(skip_spaces(line + 3));
+        return;
+    }
+    if (bench_sub_is(line, "stat")) {
+        cmd_stat(skip_spaces(line + 4));
+        return;
+    }
+
     // ipcecho <text>
     static const char ipcecho_prefix[] = "ipcecho";
     p = line;
@@ -420,6 +1274,7 @@ static void exec_line(const char *line) {
 
 void cli_run(void) {
     puts_both("\nserial CLI ready. Type `help`.\n");
+    boot_mark("first prompt");
 
     char line[128];
     size_t len = 0;
@@ -461,6 +1316,11 @@ void cli_run(void) {
             continue;
         }
 
+        if (!from_serial && (c == KBD_KEY_PAGE_UP || c == KBD_KEY_PAGE_DOWN)) {
+            vga_scrollback(c == KBD_KEY_PAGE_UP ? VGA_HEIGHT / 2 : -(VGA_HEIGHT / 2));
+            continue;
+        }
+
         if ((uint8_t)c < 0x20) {
             // ignore other control characters
             continue;
@@ -0,0 +1,149 @@
+#include "kernel/fpu.h"
+
+#include <stddef.h>
+
+#include "kernel/idt.h"
+#include "kernel/task.h"
+
+#define CPUID_EDX_FXSR     (1u << 24)
+#define CPUID_EDX_SSE      (1u << 25)
+#define CR0_MP             (1u << 1)
+#define CR0_EM             (1u << 2)
+#define CR0_TS             (1u << 3)
+#define CR0_NE             (1u << 5)
+#define CR4_OSFXSR         (1u << 9)
+#define CR4_OSXMMEXCPT     (1u << 10)
+#define MXCSR_DEFAULT      0x1F80u // all SIMD exceptions masked
+
+// Code outside any task (boot, the scheduler loop) gets its own slot.
+#define FPU_KERNEL_SLOT MAX_TASKS
+
+typedef struct {
+    uint8_t bytes[512];
+} __attribute__((aligned(16))) fxsave_area_t;
+
+static fxsave_area_t g_state[MAX_TASKS + 1];
+static uint8_t g_saved[MAX_TASKS + 1]; // g_state holds the slot's live state
+static fxsave_area_t g_initial;        // after FNINIT, for a slot's first use
+
+static int g_enabled;
+static int g_owner = -1;
+static int g_ts_set;
+static fpu_stats_t g_stats;
+
+static inline void clts(void) {
+    __asm__ volatile("clts");
+}
+
+static inline void stts(void) {
+    uint32_t cr0;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    __asm__ volatile("mov %0, %%cr0" : : "r"(cr0 | CR0_TS));
+}
+
+static inline void fxsave(fxsave_area_t *area) {
+    __asm__ volatile("fxsave %0" : "=m"(*area));
+}
+
+static inline void fxrstor(const fxsave_area_t *area) {
+    __asm__ volatile("fxrstor %0" : : "m"(*area));
+}
+
+static int current_slot(void) {
+    int id = task_get_current();
+    return id < 0 ? FPU_KERNEL_SLOT : id;
+}
+
+// Interrupt gate, so IF is clear: nothing can switch tasks in between.
+static void fpu_nm_handler(interrupt_frame_t *frame) {
+    (void)frame;
+    clts();
+    g_ts_set = 0;
+    g_stats.traps++;
+
+    int slot = current_slot();
+    if (g_owner == slot) {
+        return;
+    }
+    if (g_owner >= 0) {
+        fxsave(&g_state[g_owner]);
+        g_saved[g_owner] = 1;
+        g_stats.saves++;
+    }
+    fxrstor(g_saved[slot] ? &g_state[slot] : &g_initial);
+    g_stats.restores++;
+    g_owner = slot;
+}
+
+void fpu_init(void) {
+    uint32_t a = 1, b, c, d;
+    __asm__ volatile("cpuid" : "+a"(a), "=b"(b), "=c"(c), "=d"(d));
+
+    uint32_t cr0;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    if ((d & (CPUID_EDX_FXSR | CPUID_EDX_SSE)) != (CPUID_EDX_FXSR | CPUID_EDX_SSE)) {
+        // No lazy switching without FXSAVE: any FPU instruction faults (#NM).
+        __asm__ volatile("mov %0, %%cr0" : : "r"(cr0 | CR0_EM));
+        return;
+    }
+    __asm__ volatile("mov %0, %%cr0" : : "r"(((cr0 & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE)));
+    uint32_t cr4;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+    __asm__ volatile("mov %0, %%cr4" : : "r"(cr4 | CR4_OSFXSR | CR4_OSXMMEXCPT));
+
+    uint32_t mxcsr = MXCSR_DEFAULT;
+    __asm__ volatile("fninit");
+    __asm__ volatile("ldmxcsr %0" : : "m"(mxcsr));
+    fxsave(&g_initial);
+
+    idt_set_handler(IDT_VEC_DEVICE_NA, fpu_nm_handler);
+    g_enabled = 1;
+    g_owner = -1;
+    stts();
+    g_ts_set = 1;
+}
+
+int fpu_sse_enabled(void) {
+    return g_enabled;
+}
+
+void fpu_switch_to(int task_id) {
+    if (!g_enabled) {
+        return;
+    }
+    // Only the owner runs with TS clear; everyone else traps on first use.
+    int want_ts = task_id != g_owner;
+    if (want_ts == g_ts_set) {
+        return;
+    }
+    if (want_ts) {
+        stts();
+    } else {
+        clts();
+    }
+    g_ts_set = want_ts;
+}
+
+void fpu_task_reset(int task_id) {
+    if (!g_enabled || task_id < 0 || task_id >= MAX_TASKS) {
+        return;
+    }
+    g_saved[task_id] = 0;
+    if (g_owner == task_id) {
+        // The registers are now garbage nobody owns.
+        g_owner = -1;
+        if (!g_ts_set) {
+            stts();
+            g_ts_set = 1;
+        }
+    }
+}
+
+void fpu_get_stats(fpu_stats_t *out) {
+    if (!out) {
+        return;
+    }
+    *out = g_stats;
+    out->enabled = g_enabled;
+    out->owner = g_owner;
+}
@@ -0,0 +1,95 @@
+#include "kernel/gdt.h"
+
+#include <stddef.h>
+
+#include "kernel/kmem.h"
+
+typedef struct {
+    uint16_t limit_lo;
+    uint16_t base_lo;
+    uint8_t base_mid;
+    uint8_t access;
+    uint8_t granularity;
+    uint8_t base_hi;
+} __attribute__((packed)) gdt_entry_t;
+
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) gdt_ptr_t;
+
+typedef struct {
+    uint32_t prev_tss;
+    uint32_t esp0;
+    uint32_t ss0;
+    uint32_t esp1;
+    uint32_t ss1;
+    uint32_t esp2;
+    uint32_t ss2;
+    uint32_t cr3;
+    uint32_t eip;
+    uint32_t eflags;
+    uint32_t eax, ecx, edx, ebx, esp, ebp, esi, edi;
+    uint32_t es, cs, ss, ds, fs, gs;
+    uint32_t ldt;
+    uint16_t trap;
+    uint16_t iomap_base;
+} __attribute__((packed)) tss_t;
+
+#define GDT_ENTRIES 6
+
+static gdt_entry_t g_gdt[GDT_ENTRIES];
+static tss_t g_tss;
+
+// Read by the SYSENTER entry stub; kept in sync with g_tss.esp0.
+uint32_t g_syscall_kernel_esp = 0;
+
+static void gdt_set_entry(int idx, uint32_t base, uint32_t limit, uint8_t access, uint8_t gran) {
+    g_gdt[idx].limit_lo = (uint16_t)(limit & 0xFFFFu);
+    g_gdt[idx].base_lo = (uint16_t)(base & 0xFFFFu);
+    g_gdt[idx].base_mid = (uint8_t)((base >> 16) & 0xFFu);
+    g_gdt[idx].access = access;
+    g_gdt[idx].granularity = (uint8_t)(((limit >> 16) & 0x0Fu) | (gran & 0xF0u));
+    g_gdt[idx].base_hi = (uint8_t)((base >> 24) & 0xFFu);
+}
+
+void gdt_init(void) {
+    gdt_set_entry(0, 0, 0, 0, 0);
+    gdt_set_entry(1, 0, 0xFFFFFu, 0x9A, 0xC0); // kernel code
+    gdt_set_entry(2, 0, 0xFFFFFu, 0x92, 0xC0); // kernel data
+    gdt_set_entry(3, 0, 0xFFFFFu, 0xFA, 0xC0); // user code
+    gdt_set_entry(4, 0, 0xFFFFFu, 0xF2, 0xC0); // user data
+
+    kmemset(&g_tss, 0, sizeof(g_tss));
+    g_tss.ss0 = GDT_KERNEL_DATA;
+    g_tss.iomap_base = (uint16_t)sizeof(g_tss); // no I/O bitmap
+    gdt_set_entry(5, (uint32_t)(uintptr_t)&g_tss, sizeof(g_tss) - 1, 0x89, 0x00);
+
+    gdt_ptr_t ptr;
+    ptr.limit = (uint16_t)(sizeof(g_gdt) - 1);
+    ptr.base = (uint32_t)(uintptr_t)g_gdt;
+
+    // DS/ES/FS/GS hold the (flat) user data selector everywhere, so neither
+    // SYSEXIT nor IRET back to ring 3 has to reload them.
+    __asm__ volatile(
+        "lgdt %0\n"
+        "ljmp %1, $1f\n"
+        "1:\n"
+        "mov %2, %%ax\n"
+        "mov %%ax, %%ss\n"
+        "mov %3, %%ax\n"
+        "mov %%ax, %%ds\n"
+        "mov %%ax, %%es\n"
+        "mov %%ax, %%fs\n"
+        "mov %%ax, %%gs\n"
+        "mov %4, %%ax\n"
+        "ltr %%ax\n"
+        :
+        : "m"(ptr), "i"(GDT_KERNEL_CODE), "i"(GDT_KERNEL_DATA), "i"(GDT_USER_DATA), "i"(GDT_TSS)
+        : "eax", "memory");
+}
+
+void gdt_set_kernel_stack(uint32_t esp0) {
+    g_tss.esp0 = esp0;
+    g_syscall_kernel_esp = esp0;
+}
@@ -0,0 +1,241 @@
+#include "kernel/grant.h"
+
+#include <stddef.h>
+
+#include "kernel/paging.h"
+#include "kernel/task.h"
+
+typedef struct {
+    int active;
+    int owner_task;
+    uint32_t owner_gen;        // task_get_generation(owner_task) at creation
+    endpoint_id_t target;
+    uint32_t rights;
+    uint32_t npages;
+    uint32_t frames[GRANT_MAX_PAGES];
+    addr_space_t mapped_space; // 0 while not mapped (or mapped by identity)
+    uint32_t mapped_vaddr;
+    int mapped;
+    int mapped_task;           // who mapped it (-1: not in a task)
+} grant_t;
+
+static grant_t g_grants[GRANT_MAX];
+
+void grant_init(void) {
+    for (int i = 0; i < GRANT_MAX; i++) {
+        g_grants[i].active = 0;
+        g_grants[i].mapped = 0;
+        g_grants[i].mapped_space = 0;
+        g_grants[i].mapped_task = -1;
+    }
+}
+
+static grant_t *grant_get(grant_id_t id) {
+    if (id >= GRANT_MAX || !g_grants[id].active) {
+        return NULL;
+    }
+    return &g_grants[id];
+}
+
+// Unmap the first `npages` pages of a slot and release the slot.
+static void unmap_pages(addr_space_t space, uint32_t base, uint32_t npages) {
+    for (uint32_t i = 0; i < npages; i++) {
+        paging_unmap_private(space, base + i * PAGE_SIZE);
+    }
+    paging_slot_free(space, base);
+}
+
+void *grant_buffer_alloc(uint32_t npages, int user) {
+    if (npages == 0 || npages > GRANT_MAX_PAGES) {
+        return NULL;
+    }
+
+    addr_space_t space = paging_read_cr3();
+    if (space == paging_kernel_space()) {
+        return paging_alloc_frames(npages);
+    }
+
+    // One block of frames, so a failure below can hand it back whole.
+    uint8_t *frames = paging_alloc_frames(npages);
+    if (!frames) {
+        return NULL;
+    }
+    uint32_t base = paging_slot_alloc(space);
+    if (base == 0) {
+        paging_free_frames(frames, npages);
+        return NULL;
+    }
+    uint32_t flags = PG_WRITE | (user ? PG_USER : 0u);
+    for (uint32_t i = 0; i < npages; i++) {
+        uint32_t frame = (uint32_t)(uintptr_t)(frames + i * PAGE_SIZE);
+        if (paging_map_private(space, base + i * PAGE_SIZE, frame, flags) != 0) {
+            unmap_pages(space, base, i);
+            paging_free_frames(frames, npages);
+            return NULL;
+        }
+    }
+    return (void *)(uintptr_t)base;
+}
+
+grant_id_t grant_create(const void *addr, uint32_t npages, endpoint_id_t target, uint32_t rights) {
+    uint32_t vaddr = (uint32_t)(uintptr_t)addr;
+    if (npages == 0 || npages > GRANT_MAX_PAGES || (vaddr & (PAGE_SIZE - 1)) != 0) {
+        return GRANT_INVALID;
+    }
+    if (target == ENDPOINT_INVALID || rights == 0 || (rights & ~(GRANT_READ | GRANT_WRITE)) != 0) {
+        return GRANT_INVALID;
+    }
+
+    grant_t *g = NULL;
+    grant_id_t id = GRANT_INVALID;
+    for (grant_id_t i = 0; i < GRANT_MAX; i++) {
+        if (!g_grants[i].active) {
+            g = &g_grants[i];
+            id = i;
+            break;
+        }
+    }
+    if (!g) {
+        return GRANT_INVALID;
+    }
+
+    // Resolve the pages now: the grant names frames, not the owner's addresses.
+    addr_space_t space = paging_read_cr3();
+    for (uint32_t i = 0; i < npages; i++) {
+        uint32_t paddr;
+        uint32_t flags;
+        if (paging_translate(space, vaddr + i * PAGE_SIZE, &paddr, &flags) != 0) {
+            return GRANT_INVALID;
+        }
+        if ((rights & GRANT_WRITE) && !(flags & PG_WRITE)) {
+            return GRANT_INVALID;
+        }
+        g->frames[i] = paddr;
+    }
+
+    g->owner_task = task_get_current();
+    g->owner_gen = task_get_generation(g->owner_task);
+    g->target = target;
+    g->rights = rights;
+    g->npages = npages;
+    g->mapped = 0;
+    g->mapped_task = -1;
+    g->mapped_space = 0;
+    g->mapped_vaddr = 0;
+    g->active = 1;
+    return id;
+}
+
+int grant_map(grant_id_t id, endpoint_id_t self, uint32_t rights, int user, void **out) {
+    grant_t *g = grant_get(id);
+    if (!g || !out || g->target != self || g->mapped) {
+        return -1;
+    }
+    if (rights == 0 || (rights & ~g->rights) != 0) {
+        return -1;
+    }
+
+    addr_space_t space = paging_read_cr3();
+    if (space == paging_kernel_space()) {
+        // Only possible for identity-mapped (kernel region) frames. Ring 0 on
+        // the kernel space can write there anyway, so rights are not enforced.
+        for (uint32_t i = 1; i < g->npages; i++) {
+            if (g->frames[i] != g->frames[0] + i * PAGE_SIZE) {
+                return -1;
+            }
+        }
+        if (!paging_is_identity(g->frames[0], g->npages * PAGE_SIZE)) {
+            return -1;
+        }
+        g->mapped = 1;
+        g->mapped_space = 0;
+        g->mapped_task = task_get_current();
+        *out = (void *)(uintptr_t)g->frames[0];
+        return 0;
+    }
+
+    uint32_t base = paging_slot_alloc(space);
+    if (base == 0) {
+        return -1;
+    }
+    uint32_t flags = ((rights & GRANT_WRITE) ? PG_WRITE : 0u) | (user ? PG_USER : 0u);
+    for (uint32_t i = 0; i < g->npages; i++) {
+        if (paging_map_private(space, base + i * PAGE_SIZE, g->frames[i], flags) != 0) {
+            unmap_pages(space, base, i);
+            return -1;
+        }
+    }
+
+    g->mapped = 1;
+    g->mapped_task = task_get_current();
+    g->mapped_space = space;
+    g->mapped_vaddr = base;
+    *out = (void *)(uintptr_t)base;
+    return 0;
+}
+
+uint32_t grant_size(grant_id_t id) {
+    grant_t *g = grant_get(id);
+    return g ? g->npages * PAGE_SIZE : 0;
+}
+
+static void grant_drop_mapping(grant_t *g) {
+    if (g->mapped && g->mapped_space != 0) {
+        unmap_pages(g->mapped_space, g->mapped_vaddr, g->npages);
+    }
+    g->mapped = 0;
+    g->mapped_task = -1;
+    g->mapped_space = 0;
+    g->mapped_vaddr = 0;
+}
+
+int grant_unmap(grant_id_t id) {
+    grant_t *g = grant_get(id);
+    if (!g || !g->mapped) {
+        return -1;
+    }
+    if (g->mapped_space != 0 && g->mapped_space != paging_read_cr3()) {
+        return -1;
+    }
+    grant_drop_mapping(g);
+    return 0;
+}
+
+static int owned_by(const grant_t *g, int task_id) {
+    return g->owner_task == task_id && g->owner_gen == task_get_generation(task_id);
+}
+
+int grant_revoke(grant_id_t id) {
+    grant_t *g = grant_get(id);
+    if (!g || !owned_by(g, task_get_current())) {
+        return -1;
+    }
+    // Unmapping in another space needs no flush there: CR3 reload on the next
+    // switch to it drops its non-global TLB entries.
+    grant_drop_mapping(g);
+    g->active = 0;
+    return 0;
+}
+
+endpoint_id_t grant_target(grant_id_t id) {
+    grant_t *g = grant_get(id);
+    return g ? g->target : ENDPOINT_INVALID;
+}
+
+void grant_release_task(int task_id) {
+    if (task_id < 0) {
+        return;
+    }
+    for (int i = 0; i < GRANT_MAX; i++) {
+        grant_t *g = &g_grants[i];
+        if (!g->active) {
+            continue;
+        }
+        if (g->owner_task == task_id) {
+            grant_drop_mapping(g);
+            g->active = 0;
+        } else if (g->mapped && g->mapped_task == task_id) {
+            grant_drop_mapping(g);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#include "kernel/idt.h"
+
+#include <stddef.h>
+
+#include "kernel/gdt.h"
+#include "kernel/panic.h"
+#include "kernel/serial.h"
+#include "kernel/util.h"
+
+typedef struct {
+    uint16_t offset_lo;
+    uint16_t selector;
+    uint8_t zero;
+    uint8_t type_attr;
+    uint16_t offset_hi;
+} __attribute__((packed)) idt_entry_t;
+
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) idt_ptr_t;
+
+// 32-bit interrupt gate, present, DPL 0 / DPL 3 (reachable with `int` from ring 3).
+#define IDT_GATE_INT32 0x8Eu
+#define IDT_GATE_INT32_USER 0xEEu
+
+// Exceptions 0-31 and the remapped PIC lines 32-47.
+#define ISR_STUB_COUNT 48
+
+extern const uint32_t isr_stub_table[ISR_STUB_COUNT];
+
+static idt_entry_t g_idt[IDT_ENTRIES];
+static interrupt_handler_t g_handlers[IDT_ENTRIES];
+
+static const char *const g_exception_names[32] = {
+    "divide error", "debug", "NMI", "breakpoint",
+    "overflow", "bound range", "invalid opcode", "device not available",
+    "double fault", "coprocessor overrun", "invalid TSS", "segment not present",
+    "stack fault", "general protection", "page fault", "reserved",
+    "x87 fault", "alignment check", "machine check", "SIMD fault",
+    "virtualization", "control protection", "reserved", "reserved",
+    "reserved", "reserved", "reserved", "reserved",
+    "reserved", "reserved", "reserved", "reserved",
+};
+
+static void idt_set_gate(uint8_t vector, uint32_t handler, uint16_t selector, uint8_t type_attr) {
+    g_idt[vector].offset_lo = (uint16_t)(handler & 0xFFFFu);
+    g_idt[vector].selector = selector;
+    g_idt[vector].zero = 0;
+    g_idt[vector].type_attr = type_attr;
+    g_idt[vector].offset_hi = (uint16_t)(handler >> 16);
+}
+
+void idt_init(void) {
+    for (int i = 0; i < IDT_ENTRIES; i++) {
+        g_handlers[i] = NULL;
+        idt_set_gate((uint8_t)i, 0, 0, 0);
+    }
+    for (int i = 0; i < ISR_STUB_COUNT; i++) {
+        idt_set_gate((uint8_t)i, isr_stub_table[i], GDT_KERNEL_CODE, IDT_GATE_INT32);
+    }
+
+    idt_ptr_t ptr;
+    ptr.limit = (uint16_t)(sizeof(g_idt) - 1);
+    ptr.base = (uint32_t)(uintptr_t)g_idt;
+    __asm__ volatile("lidt %0" : : "m"(ptr));
+}
+
+void idt_set_handler(uint8_t vector, interrupt_handler_t handler) {
+    g_handlers[vector] = handler;
+}
+
+void idt_set_user_gate(uint8_t vector, uint32_t entry) {
+    idt_set_gate(vector, entry, GDT_KERNEL_CODE, IDT_GATE_INT32_USER);
+}
+
+void isr_dispatch(interrupt_frame_t *frame) {
+    uint32_t vec = frame->vector;
+    if (vec < IDT_ENTRIES && g_handlers[vec] != NULL) {
+        g_handlers[vec](frame);
+        return;
+    }
+
+    char buf[9];
+    serial_write("EXCEPTION: ");
+    serial_write(vec < 32 ? g_exception_names[vec] : "unknown vector");
+    serial_write(" at eip=0x");
+    u32_to_hex(frame->eip, buf, sizeof(buf));
+    serial_write(buf);
+    serial_write(" err=0x");
+    u32_to_hex(frame->error, buf, sizeof(buf));
+    serial_write(buf);
+    serial_write((frame->cs & 3u) ? " (ring 3)\n" : "\n");
+
+    panic("unhandled CPU exception");
+}
@@ -1,6 +1,8 @@
 #include "kernel/ipc.h"
 #include <stddef.h>
 
+#include "kernel/trace.h"
+
 // Message queue (ring buffer)
 typedef struct {
     ipc_msg_t messages[IPC_QUEUE_SIZE];
@@ -13,11 +15,13 @@ typedef struct {
 typedef struct {
     int active;
     msg_queue_t queue;
+    ipc_send_hook_t send_hook;
+    ipc_direct_handler_t direct;
+    int owner;           // task id, -1 = kernel only
 } endpoint_t;
 
 // Global endpoint table
 static endpoint_t endpoints[IPC_MAX_ENDPOINTS];
-static uint32_t next_endpoint_id = 0;
 
 void ipc_init(void) {
     for (uint32_t i = 0; i < IPC_MAX_ENDPOINTS; i++) {
@@ -25,22 +29,70 @@ void ipc_init(void) {
         endpoints[i].queue.head = 0;
         endpoints[i].queue.tail = 0;
         endpoints[i].queue.count = 0;
+        endpoints[i].send_hook = NULL;
+        endpoints[i].direct = NULL;
+        endpoints[i].owner = -1;
     }
-    next_endpoint_id = 0;
 }
 
 endpoint_id_t ipc_endpoint_create(void) {
-    if (next_endpoint_id >= IPC_MAX_ENDPOINTS) {
-        return ENDPOINT_INVALID;
+    // Lowest free id, so destroyed endpoints are reused.
+    for (endpoint_id_t id = 0; id < IPC_MAX_ENDPOINTS; id++) {
+        if (endpoints[id].active) {
+            continue;
+        }
+        endpoints[id].active = 1;
+        endpoints[id].queue.head = 0;
+        endpoints[id].queue.tail = 0;
+        endpoints[id].queue.count = 0;
+        endpoints[id].send_hook = NULL;
+        endpoints[id].direct = NULL;
+        endpoints[id].owner = -1;
+        return id;
+    }
+
+    return ENDPOINT_INVALID;
+}
+
+void ipc_endpoint_destroy(endpoint_id_t ep) {
+    if (ep >= IPC_MAX_ENDPOINTS) {
+        return;
+    }
+    endpoints[ep].active = 0;
+    endpoints[ep].queue.count = 0;
+    endpoints[ep].send_hook = NULL;
+    endpoints[ep].direct = NULL;
+    endpoints[ep].owner = -1;
+}
+
+void ipc_endpoint_set_owner(endpoint_id_t ep, int task_id) {
+    if (ep < IPC_MAX_ENDPOINTS && endpoints[ep].active) {
+        endpoints[ep].owner = task_id;
+    }
+}
+
+int ipc_endpoint_owned_by(endpoint_id_t ep, int task_id) {
+    return ep < IPC_MAX_ENDPOINTS && endpoints[ep].active && task_id >= 0 && endpoints[ep].owner == task_id;
+}
+
+void ipc_endpoint_disown(int task_id) {
+    for (uint32_t i = 0; i < IPC_MAX_ENDPOINTS; i++) {
+        if (endpoints[i].owner == task_id) {
+            endpoints[i].owner = -1;
+        }
+    }
+}
+
+void ipc_set_send_hook(endpoint_id_t ep, ipc_send_hook_t hook) {
+    if (ep < IPC_MAX_ENDPOINTS && endpoints[ep].active) {
+        endpoints[ep].send_hook = hook;
+    }
+}
+
+void ipc_set_direct_handler(endpoint_id_t ep, ipc_direct_handler_t handler) {
+    if (ep < IPC_MAX_ENDPOINTS && endpoints[ep].active) {
+        endpoints[ep].direct = handler;
     }
-    
-    endpoint_id_t id = next_endpoint_id++;
-    endpoints[id].active = 1;
-    endpoints[id].queue.head = 0;
-    endpoints[id].queue.tail = 0;
-    endpoints[id].queue.count = 0;
-    
-    return id;
 }
 
 ipc_error_t ipc_send(endpoint_id_t dst, const ipc_msg_t *msg) {
@@ -52,6 +104,19 @@ ipc_error_t ipc_send(endpoint_id_t dst, const ipc_msg_t *msg) {
         return IPC_ERR_INVALID_MSG;
     }
     
+    // One-shot: cleared before it runs, so the hook may send to dst itself.
+    if (endpoints[dst].send_hook != NULL) {
+        ipc_send_hook_t hook = endpoints[dst].send_hook;
+        endpoints[dst].send_hook = NULL;
+        hook(dst);
+    }
+
+    if (endpoints[dst].direct != NULL) {
+        trace(TRACE_IPC_SEND, dst, (uint32_t)msg->type);
+        endpoints[dst].direct(dst, msg);
+        return IPC_SUCCESS;
+    }
+
     msg_queue_t *q = &endpoints[dst].queue;
     
     if (q->count >= IPC_QUEUE_SIZE) {
@@ -62,6 +127,7 @@ ipc_error_t ipc_send(endpoint_id_t dst, const ipc_msg_t *msg) {
     q->messages[q->tail] = *msg;
     q->tail = (q->tail + 1) % IPC_QUEUE_SIZE;
     q->count++;
+    trace(TRACE_IPC_SEND, dst, (uint32_t)msg->type);
     
     return IPC_SUCCESS;
 }
@@ -85,6 +151,7 @@ ipc_error_t ipc_recv(endpoint_id_t src, ipc_msg_t *out_msg) {
     *out_msg = q->messages[q->head];
     q->head = (q->head + 1) % IPC_QUEUE_SIZE;
     q->count--;
+    trace(TRACE_IPC_RECV, src, (uint32_t)out_msg->type);
     
     return IPC_SUCCESS;
 }
@@ -96,3 +163,11 @@ int ipc_has_messages(endpoint_id_t ep) {
     
     return endpoints[ep].queue.count > 0;
 }
+
+uint32_t ipc_queue_depth(endpoint_id_t ep) {
+    if (ep >= IPC_MAX_ENDPOINTS || !endpoints[ep].active) {
+        return 0;
+    }
+
+    return endpoints[ep].queue.count;
+}
@@ -0,0 +1,79 @@
+#include "kernel/irq.h"
+
+#include <stddef.h>
+
+#include "kernel/io.h"
+
+#define PIC1_CMD 0x20
+#define PIC1_DATA 0x21
+#define PIC2_CMD 0xA0
+#define PIC2_DATA 0xA1
+
+#define PIC_EOI 0x20
+#define PIC_READ_ISR 0x0B
+
+static interrupt_handler_t g_irq_handlers[IRQ_COUNT];
+
+static void irq_common(interrupt_frame_t *frame) {
+    uint8_t irq = (uint8_t)(frame->vector - IRQ_VECTOR_BASE);
+
+    // Spurious IRQ7/IRQ15: the in-service bit is clear; no EOI for the line itself.
+    if (irq == 7 || irq == 15) {
+        uint16_t port = irq == 7 ? PIC1_CMD : PIC2_CMD;
+        outb(port, PIC_READ_ISR);
+        if (!(inb(port) & 0x80)) {
+            if (irq == 15) {
+                outb(PIC1_CMD, PIC_EOI);
+            }
+            return;
+        }
+    }
+
+    if (g_irq_handlers[irq] != NULL) {
+        g_irq_handlers[irq](frame);
+    }
+
+    if (irq >= 8) {
+        outb(PIC2_CMD, PIC_EOI);
+    }
+    outb(PIC1_CMD, PIC_EOI);
+}
+
+void irq_init(void) {
+    // ICW1: init + ICW4 follows; ICW2: vector offsets; ICW3: cascade on IRQ2; ICW4: 8086 mode.
+    outb(PIC1_CMD, 0x11);
+    outb(PIC2_CMD, 0x11);
+    outb(PIC1_DATA, IRQ_VECTOR_BASE);
+    outb(PIC2_DATA, IRQ_VECTOR_BASE + 8);
+    outb(PIC1_DATA, 0x04);
+    outb(PIC2_DATA, 0x02);
+    outb(PIC1_DATA, 0x01);
+    outb(PIC2_DATA, 0x01);
+
+    // Everything masked except the cascade line.
+    outb(PIC1_DATA, 0xFB);
+    outb(PIC2_DATA, 0xFF);
+
+    for (int i = 0; i < IRQ_COUNT; i++) {
+        g_irq_handlers[i] = NULL;
+        idt_set_handler((uint8_t)(IRQ_VECTOR_BASE + i), irq_common);
+    }
+}
+
+void irq_set_handler(uint8_t irq, interrupt_handler_t handler) {
+    if (irq >= IRQ_COUNT) {
+        return;
+    }
+    g_irq_handlers[irq] = handler;
+    irq_unmask(irq);
+}
+
+void irq_mask(uint8_t irq) {
+    uint16_t port = irq < 8 ? PIC1_DATA : PIC2_DATA;
+    outb(port, (uint8_t)(inb(port) | (1u << (irq & 7u))));
+}
+
+void irq_unmask(uint8_t irq) {
+    uint16_t port = irq < 8 ? PIC1_DATA : PIC2_DATA;
+    outb(port, (uint8_t)(inb(port) & ~(1u << (irq & 7u))));
+}
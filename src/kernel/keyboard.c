@@ -20,7 +20,9 @@ int keyboard_read_nonblocking(char *out) {
     if (!out) return 0;
     if ((inb(KBD_STATUS_PORT) & 0x01) == 0) return 0;
     uint8_t scancode = inb(KBD_DATA_PORT);
-    if (scancode & 0x80) return 0; // ignore key releases
+    if (scancode & 0x80) return 0; // ignore key releases (and the 0xE0 prefix)
+    if (scancode == 0x49) { *out = KBD_KEY_PAGE_UP; return 1; }
+    if (scancode == 0x51) { *out = KBD_KEY_PAGE_DOWN; return 1; }
     char c = kbd_scancode_to_ascii[scancode];
     if (c == 0) return 0;
     // Map Enter key to '\r' for CLI compatibility
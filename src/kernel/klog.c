@@ -0,0 +1,129 @@
+#include "kernel/klog.h"
+
+#include <stdarg.h>
+
+#include "kernel/kprintf.h"
+#include "kernel/task.h"
+
+// One single-producer/single-consumer ring per task slot, plus one for code
+// running outside any task (boot, scheduler). The owner only advances head,
+// the console only advances tail, so neither side takes a lock.
+#define KLOG_RINGS (MAX_TASKS + 1)
+#define KLOG_RING_MASK (KLOG_RING_ENTRIES - 1u)
+
+typedef struct {
+    klog_record_t rec[KLOG_RING_ENTRIES];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+} klog_ring_t;
+
+static klog_ring_t g_rings[KLOG_RINGS];
+static uint32_t g_seq;
+static klog_level_t g_min_level = KLOG_INFO;
+static klog_stats_t g_stats;
+
+static const char *const g_level_tags[] = { "[DEBUG] ", "[INFO] ", "[WARN] ", "[ERROR] " };
+
+void klog_init(void) {
+    for (int i = 0; i < KLOG_RINGS; i++) {
+        g_rings[i].head = 0;
+        g_rings[i].tail = 0;
+    }
+    g_seq = 0;
+    g_stats.written = 0;
+    g_stats.dropped = 0;
+    g_stats.shed = 0;
+}
+
+void klog_set_level(klog_level_t level) {
+    g_min_level = level;
+}
+
+void klog_write(klog_level_t level, uint32_t nargs, const char *fmt, ...) {
+    if (level < g_min_level || !fmt) {
+        return;
+    }
+
+    int task = task_get_current();
+    klog_ring_t *ring = &g_rings[task >= 0 ? task : MAX_TASKS];
+    uint32_t head = ring->head;
+    if (head - ring->tail >= KLOG_RING_ENTRIES) {
+        g_stats.dropped++;
+        return;
+    }
+
+    klog_record_t *rec = &ring->rec[head & KLOG_RING_MASK];
+    rec->fmt = fmt;
+    rec->seq = g_seq++;
+    rec->level = (uint8_t)level;
+    rec->nargs = (uint8_t)(nargs > KLOG_MAX_ARGS ? KLOG_MAX_ARGS : nargs);
+    rec->task = (int16_t)task;
+
+    va_list ap;
+    va_start(ap, fmt);
+    for (uint32_t i = 0; i < KLOG_MAX_ARGS; i++) {
+        rec->args[i] = i < rec->nargs ? va_arg(ap, uint32_t) : 0;
+    }
+    va_end(ap);
+
+    // Publish only after the record is complete.
+    __asm__ volatile ("" : : : "memory");
+    ring->head = head + 1;
+    g_stats.written++;
+}
+
+int klog_pop(klog_record_t *out) {
+    klog_ring_t *best = NULL;
+    for (int i = 0; i < KLOG_RINGS; i++) {
+        klog_ring_t *ring = &g_rings[i];
+        if (ring->tail == ring->head) {
+            continue;
+        }
+        if (!best || (int32_t)(ring->rec[ring->tail & KLOG_RING_MASK].seq -
+                               best->rec[best->tail & KLOG_RING_MASK].seq) < 0) {
+            best = ring;
+        }
+    }
+    if (!best) {
+        return 0;
+    }
+    *out = best->rec[best->tail & KLOG_RING_MASK];
+    __asm__ volatile ("" : : : "memory");
+    best->tail = best->tail + 1;
+    return 1;
+}
+
+uint32_t klog_pending(void) {
+    uint32_t n = 0;
+    for (int i = 0; i < KLOG_RINGS; i++) {
+        n += g_rings[i].head - g_rings[i].tail;
+    }
+    return n;
+}
+
+size_t klog_format(const klog_record_t *rec, char *buf, size_t size) {
+    if (!rec || !buf || size == 0) {
+        return 0;
+    }
+
+    // Arguments are all 32-bit stack slots, so passing every slot lets the
+    // format consume as many as it names; unused ones are ignored.
+    int n = ksnprintf(buf, size, "%s", g_level_tags[rec->level & 3u]);
+    size_t pos = n < (int)size ? (size_t)n : size - 1;
+    n = ksnprintf(buf + pos, size - pos, rec->fmt, rec->args[0], rec->args[1], rec->args[2], rec->args[3]);
+    pos += n < (int)(size - pos) ? (size_t)n : size - pos - 1;
+    if (pos + 1 < size) {
+        buf[pos++] = '\n';
+    }
+    return pos;
+}
+
+void klog_get_stats(klog_stats_t *out) {
+    if (out) {
+        *out = g_stats;
+    }
+}
+
+void klog_note_shed(void) {
+    g_stats.shed++;
+}
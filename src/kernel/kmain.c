@@ -1,18 +1,34 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "kernel/autobench.h"
+#include "kernel/boottime.h"
 #include "kernel/cli.h"
+#include "kernel/fpu.h"
+#include "kernel/gdt.h"
+#include "kernel/grant.h"
+#include "kernel/idt.h"
+#include "kernel/irq.h"
 #include "kernel/keyboard.h"
+#include "kernel/klog.h"
+#include "kernel/kmem.h"
+#include "kernel/multiboot2.h"
+#include "kernel/paging.h"
 #include "kernel/panic.h"
 #include "kernel/serial.h"
 #include "kernel/task.h"
+#include "kernel/timing.h"
 #include "kernel/vga.h"
 #include "kernel/ipc.h"
 #include "kernel/service_registry.h"
+#include "kernel/syscall.h"
+#include "services/block_service.h"
 #include "services/console_service.h"
 #include "services/echo_service.h"
+#include "services/fs_service.h"
 #include "services/timer_service.h"
 #include "services/monitor_service.h"
+#include "user/user_tasks.h"
 
 static void console_task(void *arg) {
     (void)arg;
@@ -22,6 +38,7 @@ static void console_task(void *arg) {
     }
 }
 
+#ifndef CONFIG_MONOLITHIC
 static void echo_task(void *arg) {
     (void)arg;
     for (;;) {
@@ -30,6 +47,15 @@ static void echo_task(void *arg) {
     }
 }
 
+static void timer_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        timer_service_process();
+        task_yield();
+    }
+}
+#endif
+
 static void monitor_task(void *arg) {
     (void)arg;
     for (;;) {
@@ -38,12 +64,81 @@ static void monitor_task(void *arg) {
     }
 }
 
+static void block_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        block_service_process();
+        task_yield();
+    }
+}
+
+static void fs_task(void *arg) {
+    (void)arg;
+    for (;;) {
+        fs_service_process();
+        task_yield();
+    }
+}
+
 static void cli_task(void *arg) {
     (void)arg;
     cli_run();
 }
 
-void kmain(void) {
+// `autobench=` on the command line: run the suites, report, exit QEMU.
+static void autobench_task(void *arg) {
+    (void)arg;
+    qemu_debug_exit((uint8_t)autobench_run());
+    // No exit device (e.g. an interactive QEMU): carry on with the CLI.
+    cli_run();
+}
+
+static block_dev_t ramdisk;
+
+// Services get their own page directory; service loops are shallow, so they
+// get small stacks (see `mem`).
+static const task_attr_t service_attr = { .flags = TASK_FLAG_ISOLATED, .stack_size = 2048 };
+
+static int start_service_task(const char *name, task_entry_t entry, endpoint_id_t ep, const char *mark) {
+    int tid = task_create_ex(name, entry, NULL, &service_attr);
+    if (tid < 0) {
+        return -1;
+    }
+    monitor_register_service(tid, ep, name);
+    boot_mark(mark);
+    return 0;
+}
+
+static int start_block(void) {
+    return start_service_task(BLOCK_SERVICE_NAME, block_task, block_service_get_endpoint(), "block started");
+}
+
+static int start_fs(void) {
+    return start_service_task(FS_SERVICE_NAME, fs_task, fs_service_get_endpoint(), "fs started");
+}
+
+#ifndef CONFIG_MONOLITHIC
+static int start_timer(void) {
+    return start_service_task(TIMER_SERVICE_NAME, timer_task, timer_service_get_endpoint(), "timer started");
+}
+#endif
+
+// Lazy unless the kernel command line says `eager`: the registry starts the
+// task on the first lookup or message.
+static void start_or_defer(const char *name, endpoint_id_t ep, service_start_fn_t start) {
+    if (ep == ENDPOINT_INVALID) {
+        return;
+    }
+    if (multiboot2_cmdline_get("eager") != NULL || service_set_lazy(name, start) != 0) {
+        (void)start();
+    }
+}
+
+void kmain(uint32_t mb_magic, uint32_t mb_info) {
+    boot_mark("entry");
+    // Boot information first: it is read through physical addresses.
+    multiboot2_init(mb_magic, mb_info);
+
     vga_init();
     vga_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLUE);
     vga_puts("microkernel: booted (i386)\n");
@@ -51,35 +146,88 @@ void kmain(void) {
     serial_init();
     serial_write("microkernel: serial online\n");
     keyboard_init();
+    boot_mark("vga, serial, keyboard");
+
+    // Exceptions first, so a bad mapping reports a fault instead of triple-faulting.
+    gdt_init();
+    idt_init();
+    irq_init();
+    fpu_init();
+    serial_set_async(1);
+    syscall_init();
+    boot_mark("gdt, idt, irq, fpu, syscall");
+    paging_init();
+    // Modules (the RAM disk) may lie above the first 4 MB.
+    if (multiboot2_map_modules() != 0) {
+        serial_write("multiboot2: failed to map boot modules\n");
+    }
+    boot_mark("paging");
+    clock_init();
+    kmem_init();
+    boot_mark("tsc calibration, kmem");
 
     // Initialize IPC subsystem
     ipc_init();
-    serial_write("IPC: initialized\n");
+    klog_init();
+    grant_init();
+    // Boot messages from here on go through klog, so they cost no serial time now.
+    klog(KLOG_INFO, "paging: enabled (kernel on 4 MB PSE pages)");
+    klog(KLOG_INFO, "clock: tsc %u kHz (%s)%s", clock_tsc_khz(), clock_source(),
+         (tsc_caps & TSC_CAP_INVARIANT) ? ", invariant" : "");
+    klog(KLOG_INFO, "kmem: large copies use %s", kmem_impl_name(kmem_impl()));
 
     // Initialize service registry
     service_registry_init();
-    serial_write("Service registry: initialized\n");
+    boot_mark("ipc, klog, grants, registry");
 
     // Initialize services
     console_service_init();
     echo_service_init();
     timer_service_init();
     monitor_service_init();
-    serial_write("Services: all initialized\n");
-
-    // List registered services
-    service_list_all();
+    const mb2_module_t *rd = multiboot2_find_module("ramdisk");
+    block_service_init(rd && ramdisk_init(&ramdisk, (void *)(uintptr_t)rd->start, rd->end - rd->start) == 0
+                           ? &ramdisk
+                           : NULL);
+    const mb2_module_t *initrd = multiboot2_find_module("initrd");
+    fs_service_init(initrd ? (const void *)(uintptr_t)initrd->start : NULL, initrd ? initrd->end - initrd->start : 0);
+    boot_mark("service init");
 
     vga_puts("\nUI: serial CLI ready (type into QEMU console).\n");
     vga_puts("Type `help` for commands.\n");
     vga_puts("Try 'crash' to test fault isolation!\n");
 
-    // Start cooperative tasks
+    // Start cooperative tasks; the CLI stays on the kernel space.
     task_init();
-    int console_tid = task_create("console", console_task, NULL);
-    int echo_tid = task_create("echo", echo_task, NULL);
-    (void)task_create("monitor", monitor_task, NULL);
-    (void)task_create("cli", cli_task, NULL);
+    int console_tid = task_create_ex("console", console_task, NULL, &service_attr);
+#ifdef CONFIG_MONOLITHIC
+    // MODE=monolithic: console, echo and timer requests run as direct calls in
+    // the sender's context, for comparison with message passing. The console
+    // task stays to drain klog and flush output.
+    int echo_tid = -1;
+    ipc_set_direct_handler(console_service_get_endpoint(), console_service_handle);
+    ipc_set_direct_handler(echo_service_get_endpoint(), echo_service_handle);
+    ipc_set_direct_handler(timer_service_get_endpoint(), timer_service_handle);
+    klog(KLOG_INFO, "monolithic build: console, echo and timer are direct calls");
+#else
+    int echo_tid;
+    if (syscall_fast_path_available()) {
+        // Echo runs in ring 3 and reaches IPC through SYSENTER.
+        task_attr_t user = { .flags = TASK_FLAG_USER, .stack_size = 2048 };
+        echo_tid = task_create_ex("echo", echo_user_main,
+                                  USER_ECHO_ARG(echo_service_get_endpoint(), monitor_service_get_endpoint()), &user);
+        ipc_endpoint_set_owner(echo_service_get_endpoint(), echo_tid);
+        klog(KLOG_INFO, "echo: running in ring 3");
+    } else {
+        echo_tid = task_create_ex("echo", echo_task, NULL, &service_attr);
+    }
+#endif
+    (void)task_create_ex("monitor", monitor_task, NULL, &service_attr);
+    if (autobench_requested()) {
+        (void)task_create("autobench", autobench_task, NULL);
+    } else {
+        (void)task_create("cli", cli_task, NULL);
+    }
 
     // Register services for restart (echo is the crash demo target)
     if (echo_tid >= 0) {
@@ -88,7 +236,25 @@ void kmain(void) {
     if (console_tid >= 0) {
         monitor_register_service(console_tid, console_service_get_endpoint(), CONSOLE_SERVICE_NAME);
     }
+    // Services beat every MONITOR_HEARTBEAT_INTERVAL; allow a few missed beats.
+    monitor_set_heartbeat_deadline(console_service_get_endpoint(), 8u * MONITOR_HEARTBEAT_INTERVAL);
+#ifndef CONFIG_MONOLITHIC
+    monitor_set_heartbeat_deadline(echo_service_get_endpoint(), 8u * MONITOR_HEARTBEAT_INTERVAL);
+    // Up to two extra echo instances while its queue stays backed up.
+    monitor_set_autoscale(ECHO_SERVICE_NAME, echo_service_spawn_replica, 2);
+#endif
+
+    // Storage services are only needed once something asks for them.
+    start_or_defer(BLOCK_SERVICE_NAME, block_service_get_endpoint(), start_block);
+    start_or_defer(FS_SERVICE_NAME, fs_service_get_endpoint(), start_fs);
+#ifndef CONFIG_MONOLITHIC
+    // So is the timer task: it only serves explicit tick requests.
+    start_or_defer(TIMER_SERVICE_NAME, timer_service_get_endpoint(), start_timer);
+#endif
+    boot_mark("tasks created");
 
+    // Device IRQs (COM1 transmit) from here on; tasks start with IF=1.
+    __asm__ volatile ("sti");
     scheduler_run();
 
     panic("scheduler exited");
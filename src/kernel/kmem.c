@@ -0,0 +1,326 @@
+#include "kernel/kmem.h"
+
+#include "kernel/fpu.h"
+
+// Below KMEM_UNROLL_MAX bytes the unrolled loops win over the startup cost of
+// a string instruction; from KMEM_SSE2_MIN on, aligning for SSE2 pays off.
+#define KMEM_UNROLL_MAX 128u
+#define KMEM_SSE2_MIN   512u
+
+#define CPUID_EDX_SSE2     (1u << 26)
+#define CPUID_7_EBX_ERMS   (1u << 9)
+
+#if defined(__i386__) || defined(__x86_64__)
+#define KMEM_HAVE_REP 1
+#endif
+
+// Unaligned, alias-anything views for the unrolled paths.
+typedef uint32_t __attribute__((may_alias, aligned(1))) kmem_u32_t;
+typedef uint16_t __attribute__((may_alias, aligned(1))) kmem_u16_t;
+
+#if defined(__i386__)
+// src/arch/i386/kmem_sse.S: 64-byte blocks to a 16-byte aligned dst.
+void kmem_copy_sse2(void *dst, const void *src, size_t blocks);
+void kmem_fill_sse2(void *dst, uint32_t pattern, size_t blocks);
+size_t kmem_cmp_sse2(const void *a, const void *b, size_t blocks);
+#endif
+
+static kmem_impl_t g_impl = KMEM_IMPL_REP;
+static uint32_t g_supported = 1u << KMEM_IMPL_REP;
+
+static const char *const g_impl_names[KMEM_IMPL_COUNT] = {"rep", "erms", "sse2"};
+
+static void copy_unrolled(uint8_t *d, const uint8_t *s, size_t n) {
+    while (n >= 16) {
+        uint32_t a = *(const kmem_u32_t *)s;
+        uint32_t b = *(const kmem_u32_t *)(s + 4);
+        uint32_t c = *(const kmem_u32_t *)(s + 8);
+        uint32_t e = *(const kmem_u32_t *)(s + 12);
+        *(kmem_u32_t *)d = a;
+        *(kmem_u32_t *)(d + 4) = b;
+        *(kmem_u32_t *)(d + 8) = c;
+        *(kmem_u32_t *)(d + 12) = e;
+        d += 16;
+        s += 16;
+        n -= 16;
+    }
+    if (n & 8) {
+        uint32_t a = *(const kmem_u32_t *)s;
+        uint32_t b = *(const kmem_u32_t *)(s + 4);
+        *(kmem_u32_t *)d = a;
+        *(kmem_u32_t *)(d + 4) = b;
+        d += 8;
+        s += 8;
+    }
+    if (n & 4) {
+        *(kmem_u32_t *)d = *(const kmem_u32_t *)s;
+        d += 4;
+        s += 4;
+    }
+    if (n & 2) {
+        *(kmem_u16_t *)d = *(const kmem_u16_t *)s;
+        d += 2;
+        s += 2;
+    }
+    if (n & 1) {
+        *d = *s;
+    }
+}
+
+// Stores the little-endian repetition of `pattern` starting at d.
+static void fill_unrolled(uint8_t *d, uint32_t pattern, size_t n) {
+    while (n >= 16) {
+        *(kmem_u32_t *)d = pattern;
+        *(kmem_u32_t *)(d + 4) = pattern;
+        *(kmem_u32_t *)(d + 8) = pattern;
+        *(kmem_u32_t *)(d + 12) = pattern;
+        d += 16;
+        n -= 16;
+    }
+    if (n & 8) {
+        *(kmem_u32_t *)d = pattern;
+        *(kmem_u32_t *)(d + 4) = pattern;
+        d += 8;
+    }
+    if (n & 4) {
+        *(kmem_u32_t *)d = pattern;
+        d += 4;
+    }
+    if (n & 2) {
+        *(kmem_u16_t *)d = (uint16_t)pattern;
+        pattern >>= 16;
+        d += 2;
+    }
+    if (n & 1) {
+        *d = (uint8_t)pattern;
+    }
+}
+
+#if defined(KMEM_HAVE_REP)
+static void copy_rep(uint8_t *d, const uint8_t *s, size_t n) {
+    size_t words = n >> 2;
+    __asm__ volatile("rep movsl" : "+D"(d), "+S"(s), "+c"(words) : : "memory");
+    copy_unrolled(d, s, n & 3u);
+}
+
+static void copy_erms(uint8_t *d, const uint8_t *s, size_t n) {
+    __asm__ volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+}
+
+static void fill_rep(uint8_t *d, uint32_t pattern, size_t n) {
+    size_t words = n >> 2;
+    __asm__ volatile("rep stosl" : "+D"(d), "+c"(words) : "a"(pattern) : "memory");
+    fill_unrolled(d, pattern, n & 3u);
+}
+
+static void fill_erms(uint8_t *d, uint8_t c, size_t n) {
+    __asm__ volatile("rep stosb" : "+D"(d), "+c"(n) : "a"(c) : "memory");
+}
+#endif
+
+#if defined(__i386__)
+// The pattern as seen from `off` bytes into the fill.
+static uint32_t pattern_at(uint32_t pattern, uintptr_t off) {
+    uint32_t shift = (uint32_t)(off & 3u) * 8u;
+    return shift == 0 ? pattern : (pattern >> shift) | (pattern << (32u - shift));
+}
+
+static void copy_sse2(uint8_t *d, const uint8_t *s, size_t n) {
+    size_t head = (16u - ((uintptr_t)d & 15u)) & 15u;
+    copy_unrolled(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+    size_t blocks = n >> 6;
+    kmem_copy_sse2(d, s, blocks);
+    copy_unrolled(d + (blocks << 6), s + (blocks << 6), n & 63u);
+}
+
+static void fill_sse2(uint8_t *d, uint32_t pattern, size_t n) {
+    size_t head = (16u - ((uintptr_t)d & 15u)) & 15u;
+    fill_unrolled(d, pattern, head);
+    d += head;
+    n -= head;
+    // Blocks and the tail both start a multiple of 4 bytes past the head.
+    pattern = pattern_at(pattern, head);
+    size_t blocks = n >> 6;
+    kmem_fill_sse2(d, pattern, blocks);
+    fill_unrolled(d + (blocks << 6), pattern, n & 63u);
+}
+#endif
+
+void *kmemcpy(void *dst, const void *src, size_t n) {
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    if (n < KMEM_UNROLL_MAX) {
+        copy_unrolled(d, s, n);
+        return dst;
+    }
+#if defined(__i386__)
+    if (g_impl == KMEM_IMPL_SSE2 && n >= KMEM_SSE2_MIN) {
+        copy_sse2(d, s, n);
+        return dst;
+    }
+#endif
+#if defined(KMEM_HAVE_REP)
+    if (g_impl == KMEM_IMPL_ERMS) {
+        copy_erms(d, s, n);
+    } else {
+        copy_rep(d, s, n);
+    }
+#else
+    copy_unrolled(d, s, n);
+#endif
+    return dst;
+}
+
+// Shared by the byte, 16-bit and 32-bit fills; `pattern` repeats every 4 bytes.
+static void fill(uint8_t *d, uint32_t pattern, size_t n, int bytewise) {
+    if (n < KMEM_UNROLL_MAX) {
+        fill_unrolled(d, pattern, n);
+        return;
+    }
+#if defined(__i386__)
+    if (g_impl == KMEM_IMPL_SSE2 && n >= KMEM_SSE2_MIN) {
+        fill_sse2(d, pattern, n);
+        return;
+    }
+#endif
+#if defined(KMEM_HAVE_REP)
+    if (g_impl == KMEM_IMPL_ERMS && bytewise) {
+        fill_erms(d, (uint8_t)pattern, n);
+    } else {
+        fill_rep(d, pattern, n);
+    }
+#else
+    (void)bytewise;
+    fill_unrolled(d, pattern, n);
+#endif
+}
+
+void *kmemset(void *dst, int c, size_t n) {
+    fill((uint8_t *)dst, (uint8_t)c * 0x01010101u, n, 1);
+    return dst;
+}
+
+void kmemset16(void *dst, uint16_t value, size_t count) {
+    fill((uint8_t *)dst, value | (uint32_t)value << 16, count * 2u, 0);
+}
+
+void kmemset32(void *dst, uint32_t value, size_t count) {
+    fill((uint8_t *)dst, value, count * 4u, 0);
+}
+
+static int cmp_bytes(const uint8_t *p, const uint8_t *q, size_t n) {
+    for (; n > 0; n--, p++, q++) {
+        if (*p != *q) {
+            return *p < *q ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+int kmemcmp(const void *a, const void *b, size_t n) {
+    const uint8_t *p = (const uint8_t *)a;
+    const uint8_t *q = (const uint8_t *)b;
+    if (n < 8) {
+        return cmp_bytes(p, q, n);
+    }
+#if defined(__i386__)
+    // Skip equal 64-byte blocks; a differing one is left for the code below.
+    if (g_impl == KMEM_IMPL_SSE2 && n >= KMEM_SSE2_MIN) {
+        size_t same = kmem_cmp_sse2(p, q, n >> 6) << 6;
+        p += same;
+        q += same;
+        n -= same;
+    }
+#endif
+    // 16 bytes per branch until something differs, then narrow down to the
+    // dword and the byte.
+    while (n >= 16) {
+        uint32_t diff = (*(const kmem_u32_t *)p ^ *(const kmem_u32_t *)q) |
+                        (*(const kmem_u32_t *)(p + 4) ^ *(const kmem_u32_t *)(q + 4)) |
+                        (*(const kmem_u32_t *)(p + 8) ^ *(const kmem_u32_t *)(q + 8)) |
+                        (*(const kmem_u32_t *)(p + 12) ^ *(const kmem_u32_t *)(q + 12));
+        if (diff != 0) {
+            break;
+        }
+        p += 16;
+        q += 16;
+        n -= 16;
+    }
+    while (n >= 4 && *(const kmem_u32_t *)p == *(const kmem_u32_t *)q) {
+        p += 4;
+        q += 4;
+        n -= 4;
+    }
+    return cmp_bytes(p, q, n);
+}
+
+#if defined(__i386__)
+static void cpuid(uint32_t leaf, uint32_t *a, uint32_t *b, uint32_t *c, uint32_t *d) {
+    __asm__ volatile("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(0));
+}
+#endif
+
+void kmem_init(void) {
+#if defined(__i386__)
+    uint32_t max_leaf, a, b, c, d;
+    cpuid(0, &max_leaf, &b, &c, &d);
+    cpuid(1, &a, &b, &c, &d);
+    if ((d & CPUID_EDX_SSE2) && fpu_sse_enabled()) {
+        g_supported |= 1u << KMEM_IMPL_SSE2;
+    }
+    if (max_leaf >= 7) {
+        cpuid(7, &a, &b, &c, &d);
+        if (b & CPUID_7_EBX_ERMS) {
+            g_supported |= 1u << KMEM_IMPL_ERMS;
+        }
+    }
+    // Fast strings match SSE2 on large copies, and an SSE2 copy makes the
+    // calling task an FPU owner (see kernel/fpu.h).
+    if (g_supported & (1u << KMEM_IMPL_ERMS)) {
+        g_impl = KMEM_IMPL_ERMS;
+    } else if (g_supported & (1u << KMEM_IMPL_SSE2)) {
+        g_impl = KMEM_IMPL_SSE2;
+    }
+#endif
+}
+
+kmem_impl_t kmem_impl(void) {
+    return g_impl;
+}
+
+const char *kmem_impl_name(kmem_impl_t impl) {
+    return impl < KMEM_IMPL_COUNT ? g_impl_names[impl] : "?";
+}
+
+// Mirrors the dispatch in kmemcpy/fill/kmemcmp. Strategy paths return the
+// kmem_impl_name() string itself, so callers may compare pointers.
+const char *kmem_path_name(size_t n, int cmp) {
+#if defined(__i386__)
+    if (g_impl == KMEM_IMPL_SSE2 && n >= KMEM_SSE2_MIN) {
+        return g_impl_names[KMEM_IMPL_SSE2];
+    }
+#endif
+    if (cmp || n < KMEM_UNROLL_MAX) {
+        return "unrolled";
+    }
+#if defined(KMEM_HAVE_REP)
+    return g_impl_names[g_impl == KMEM_IMPL_ERMS ? KMEM_IMPL_ERMS : KMEM_IMPL_REP];
+#else
+    return "unrolled";
+#endif
+}
+
+int kmem_impl_supported(kmem_impl_t impl) {
+    return impl < KMEM_IMPL_COUNT && (g_supported & (1u << impl)) != 0;
+}
+
+int kmem_set_impl(kmem_impl_t impl) {
+    if (!kmem_impl_supported(impl)) {
+        return -1;
+    }
+    g_impl = impl;
+    return 0;
+}
@@ -0,0 +1,236 @@
+#include "kernel/kprintf.h"
+
+#include <stdint.h>
+
+#include "kernel/serial.h"
+#include "kernel/util.h"
+#include "kernel/vga.h"
+
+// "00" "01" ... "99": two digits per lookup.
+static const char g_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the digits of v ending just before *end; returns the start.
+// n / 100 is a multiply by the 2^37 / 100 reciprocal and a shift.
+static char *fmt_u32_rev(uint32_t v, char *end) {
+    char *p = end;
+    while (v >= 100) {
+        uint32_t q = (uint32_t)(((uint64_t)v * 0x51EB851Fu) >> 37);
+        uint32_t r = v - q * 100u;
+        p -= 2;
+        p[0] = g_digit_pairs[r * 2];
+        p[1] = g_digit_pairs[r * 2 + 1];
+        v = q;
+    }
+    if (v >= 10) {
+        p -= 2;
+        p[0] = g_digit_pairs[v * 2];
+        p[1] = g_digit_pairs[v * 2 + 1];
+    } else {
+        *--p = (char)('0' + v);
+    }
+    return p;
+}
+
+// 64-bit values are cut into base-10^9 chunks with u64_div_u32 (DIV on
+// EDX:EAX), so no libgcc division helper is needed.
+static char *fmt_u64_rev(uint64_t v, char *end) {
+    char *p = end;
+    while ((v >> 32) != 0) {
+        uint32_t chunk;
+        v = u64_div_u32(v, 1000000000u, &chunk);
+        char *q = fmt_u32_rev(chunk, p);
+        while (q > p - 9) {
+            *--q = '0';
+        }
+        p = q;
+    }
+    return fmt_u32_rev((uint32_t)v, p);
+}
+
+static char *fmt_hex_rev(uint64_t v, char *end, int upper) {
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char *p = end;
+    do {
+        *--p = digits[v & 0xFu];
+        v >>= 4;
+    } while (v != 0);
+    return p;
+}
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t pos; // may run past size; only the stored part is bounded
+} kfmt_out_t;
+
+static void out_char(kfmt_out_t *o, char c) {
+    if (o->pos + 1 < o->size) {
+        o->buf[o->pos] = c;
+    }
+    o->pos++;
+}
+
+static void out_field(kfmt_out_t *o, const char *s, size_t len, int width, int left, char pad) {
+    size_t fill = width > 0 && (size_t)width > len ? (size_t)width - len : 0;
+    if (!left) {
+        // Zero padding goes after a sign.
+        if (pad == '0' && len > 0 && s[0] == '-') {
+            out_char(o, '-');
+            s++;
+            len--;
+        }
+        for (size_t i = 0; i < fill; i++) {
+            out_char(o, pad);
+        }
+    }
+    for (size_t i = 0; i < len; i++) {
+        out_char(o, s[i]);
+    }
+    if (left) {
+        for (size_t i = 0; i < fill; i++) {
+            out_char(o, ' ');
+        }
+    }
+}
+
+int kvsnprintf(char *buf, size_t size, const char *fmt, va_list ap) {
+    kfmt_out_t o = { buf, buf ? size : 0, 0 };
+    if (!fmt) {
+        fmt = "";
+    }
+
+    for (const char *f = fmt; *f; f++) {
+        if (*f != '%') {
+            out_char(&o, *f);
+            continue;
+        }
+        f++;
+
+        int left = 0;
+        char pad = ' ';
+        for (;; f++) {
+            if (*f == '-') {
+                left = 1;
+            } else if (*f == '0') {
+                pad = '0';
+            } else {
+                break;
+            }
+        }
+
+        int width = 0;
+        if (*f == '*') {
+            width = va_arg(ap, int);
+            if (width < 0) {
+                left = 1;
+                width = -width;
+            }
+            f++;
+        } else {
+            while (*f >= '0' && *f <= '9') {
+                width = width * 10 + (*f - '0');
+                f++;
+            }
+        }
+
+        int longlong = 0;
+        if (*f == 'l') {
+            f++;
+            if (*f == 'l') {
+                longlong = 1;
+                f++;
+            }
+        }
+
+        // Large enough for a 64-bit value in decimal, sign included.
+        char tmp[24];
+        char *end = tmp + sizeof(tmp);
+        char *start = end;
+        switch (*f) {
+        case 'd':
+        case 'i': {
+            int64_t v = longlong ? va_arg(ap, int64_t) : (int64_t)va_arg(ap, int32_t);
+            uint64_t mag = v < 0 ? 0u - (uint64_t)v : (uint64_t)v;
+            start = fmt_u64_rev(mag, end);
+            if (v < 0) {
+                *--start = '-';
+            }
+            break;
+        }
+        case 'u':
+            start = longlong ? fmt_u64_rev(va_arg(ap, uint64_t), end) : fmt_u32_rev(va_arg(ap, uint32_t), end);
+            break;
+        case 'x':
+        case 'X':
+            start = fmt_hex_rev(longlong ? va_arg(ap, uint64_t) : va_arg(ap, uint32_t), end, *f == 'X');
+            break;
+        case 'p':
+            start = fmt_hex_rev((uintptr_t)va_arg(ap, void *), end, 0);
+            while (start > end - 8) {
+                *--start = '0';
+            }
+            *--start = 'x';
+            *--start = '0';
+            pad = ' ';
+            break;
+        case 'c':
+            *--start = (char)va_arg(ap, int);
+            break;
+        case 's': {
+            const char *s = va_arg(ap, const char *);
+            if (!s) {
+                s = "(null)";
+            }
+            out_field(&o, s, str_len(s), width, left, ' ');
+            continue;
+        }
+        case '%':
+            out_char(&o, '%');
+            continue;
+        case '\0':
+            f--; // trailing '%': stop at the terminator
+            continue;
+        default:
+            out_char(&o, '%');
+            out_char(&o, *f);
+            continue;
+        }
+        out_field(&o, start, (size_t)(end - start), width, left, left ? ' ' : pad);
+    }
+
+    if (o.size > 0) {
+        o.buf[o.pos < o.size ? o.pos : o.size - 1] = '\0';
+    }
+    return (int)o.pos;
+}
+
+int ksnprintf(char *buf, size_t size, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = kvsnprintf(buf, size, fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+int kprintf(const char *fmt, ...) {
+    char buf[KPRINTF_BUF_SIZE];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = kvsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    size_t len = n < (int)sizeof(buf) ? (size_t)n : sizeof(buf) - 1;
+    vga_write(buf, len);
+    serial_write_len(buf, len);
+    return n;
+}
@@ -0,0 +1,129 @@
+#include "kernel/kstack.h"
+
+#include "kernel/kmem.h"
+
+// Blocks are kept sorted by offset and tile the arena, so neighbours can be
+// merged on free. A small fixed table is plenty for MAX_TASKS stacks.
+#define KSTACK_MAX_BLOCKS 16
+
+#define KSTACK_GUARD_WORD 0xDEADF00Du
+
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+    int used;
+} kstack_block_t;
+
+static uint8_t g_arena[KSTACK_ARENA_SIZE] __attribute__((aligned(KSTACK_ALIGN)));
+static kstack_block_t g_blocks[KSTACK_MAX_BLOCKS];
+static uint32_t g_block_count = 0;
+
+static void remove_block(uint32_t idx) {
+    for (uint32_t i = idx; i + 1 < g_block_count; i++) {
+        g_blocks[i] = g_blocks[i + 1];
+    }
+    g_block_count--;
+}
+
+void kstack_init(void) {
+    g_blocks[0].offset = 0;
+    g_blocks[0].size = KSTACK_ARENA_SIZE;
+    g_blocks[0].used = 0;
+    g_block_count = 1;
+}
+
+void kstack_guard_reset(void *stack) {
+    kmemset32((uint8_t *)stack - KSTACK_GUARD_SIZE, KSTACK_GUARD_WORD, KSTACK_GUARD_SIZE / sizeof(uint32_t));
+}
+
+int kstack_guard_intact(const void *stack) {
+    const uint32_t *w = (const uint32_t *)((const uint8_t *)stack - KSTACK_GUARD_SIZE);
+    for (uint32_t i = 0; i < KSTACK_GUARD_SIZE / sizeof(uint32_t); i++) {
+        if (w[i] != KSTACK_GUARD_WORD) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Blocks hold the guard band, then the stack the caller sees.
+void *kstack_alloc(uint32_t size) {
+    if (size == 0 || size > KSTACK_ARENA_SIZE - KSTACK_GUARD_SIZE) {
+        return NULL;
+    }
+    size = ((size + KSTACK_ALIGN - 1) & ~(KSTACK_ALIGN - 1)) + KSTACK_GUARD_SIZE;
+
+    for (uint32_t i = 0; i < g_block_count; i++) {
+        kstack_block_t *b = &g_blocks[i];
+        if (b->used || b->size < size) {
+            continue;
+        }
+
+        // Split off the tail as a new free block if the table has room;
+        // otherwise hand out the whole block.
+        if (b->size > size && g_block_count < KSTACK_MAX_BLOCKS) {
+            for (uint32_t j = g_block_count; j > i + 1; j--) {
+                g_blocks[j] = g_blocks[j - 1];
+            }
+            g_blocks[i + 1].offset = b->offset + size;
+            g_blocks[i + 1].size = b->size - size;
+            g_blocks[i + 1].used = 0;
+            g_block_count++;
+            b->size = size;
+        }
+        b->used = 1;
+        void *stack = &g_arena[b->offset + KSTACK_GUARD_SIZE];
+        kstack_guard_reset(stack);
+        return stack;
+    }
+    return NULL;
+}
+
+void kstack_free(void *stack) {
+    if (!stack) {
+        return;
+    }
+    uint32_t offset = (uint32_t)((uint8_t *)stack - g_arena) - KSTACK_GUARD_SIZE;
+
+    for (uint32_t i = 0; i < g_block_count; i++) {
+        if (g_blocks[i].offset != offset || !g_blocks[i].used) {
+            continue;
+        }
+
+        g_blocks[i].used = 0;
+        if (i + 1 < g_block_count && !g_blocks[i + 1].used) {
+            g_blocks[i].size += g_blocks[i + 1].size;
+            remove_block(i + 1);
+        }
+        if (i > 0 && !g_blocks[i - 1].used) {
+            g_blocks[i - 1].size += g_blocks[i].size;
+            remove_block(i);
+        }
+        return;
+    }
+}
+
+void kstack_stats(uint32_t *used, uint32_t *free_bytes, uint32_t *largest_free) {
+    uint32_t u = 0;
+    uint32_t f = 0;
+    uint32_t largest = 0;
+    for (uint32_t i = 0; i < g_block_count; i++) {
+        if (g_blocks[i].used) {
+            u += g_blocks[i].size;
+        } else {
+            f += g_blocks[i].size;
+            if (g_blocks[i].size > largest) {
+                largest = g_blocks[i].size;
+            }
+        }
+    }
+    if (used) {
+        *used = u;
+    }
+    if (free_bytes) {
+        *free_bytes = f;
+    }
+    if (largest_free) {
+        *largest_free = largest;
+    }
+}
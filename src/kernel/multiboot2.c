@@ -0,0 +1,121 @@
+#include "kernel/multiboot2.h"
+
+#include <stddef.h>
+
+#include "kernel/paging.h"
+#include "kernel/util.h"
+
+#define MB2_TAG_END     0
+#define MB2_TAG_CMDLINE 1
+#define MB2_TAG_MODULE  3
+
+typedef struct {
+    uint32_t type;
+    uint32_t size;
+} mb2_tag_t;
+
+typedef struct {
+    mb2_tag_t tag;
+    uint32_t mod_start;
+    uint32_t mod_end;
+    char cmdline[];
+} mb2_tag_module_t;
+
+static int g_present;
+static char g_cmdline[MB2_CMDLINE_MAX];
+static mb2_module_t g_modules[MB2_MAX_MODULES];
+static uint32_t g_module_count;
+
+void multiboot2_init(uint32_t magic, uint32_t info_addr) {
+    g_present = 0;
+    g_cmdline[0] = '\0';
+    g_module_count = 0;
+    if (magic != MULTIBOOT2_BOOTLOADER_MAGIC || info_addr == 0) {
+        return;
+    }
+    g_present = 1;
+
+    // Fixed part: total_size, reserved; tags follow, each 8-byte aligned.
+    uint32_t total = *(const uint32_t *)(uintptr_t)info_addr;
+    uint32_t off = 8;
+    while (off + sizeof(mb2_tag_t) <= total) {
+        const mb2_tag_t *tag = (const mb2_tag_t *)(uintptr_t)(info_addr + off);
+        if (tag->type == MB2_TAG_END || tag->size < sizeof(mb2_tag_t)) {
+            break;
+        }
+        if (tag->type == MB2_TAG_CMDLINE) {
+            str_copy_safe(g_cmdline, (const char *)(tag + 1), sizeof(g_cmdline));
+        } else if (tag->type == MB2_TAG_MODULE && g_module_count < MB2_MAX_MODULES) {
+            const mb2_tag_module_t *mod = (const mb2_tag_module_t *)tag;
+            mb2_module_t *m = &g_modules[g_module_count++];
+            m->start = mod->mod_start;
+            m->end = mod->mod_end;
+            str_copy_safe(m->cmdline, mod->cmdline, sizeof(m->cmdline));
+        }
+        off += (tag->size + 7u) & ~7u;
+    }
+}
+
+int multiboot2_present(void) {
+    return g_present;
+}
+
+const char *multiboot2_cmdline(void) {
+    return g_cmdline;
+}
+
+const char *multiboot2_cmdline_get(const char *key) {
+    const char *p = g_cmdline;
+    while (*p) {
+        while (*p == ' ') {
+            p++;
+        }
+        size_t k = 0;
+        while (key[k] != '\0' && p[k] == key[k]) {
+            k++;
+        }
+        if (key[k] == '\0' && (p[k] == '\0' || p[k] == ' ')) {
+            return "";
+        }
+        if (key[k] == '\0' && p[k] == '=') {
+            return p + k + 1;
+        }
+        while (*p && *p != ' ') {
+            p++;
+        }
+    }
+    return NULL;
+}
+
+uint32_t multiboot2_module_count(void) {
+    return g_module_count;
+}
+
+const mb2_module_t *multiboot2_module(uint32_t index) {
+    return index < g_module_count ? &g_modules[index] : NULL;
+}
+
+const mb2_module_t *multiboot2_find_module(const char *name) {
+    for (uint32_t i = 0; i < g_module_count; i++) {
+        const char *c = g_modules[i].cmdline;
+        size_t k = 0;
+        while (name[k] != '\0' && c[k] == name[k]) {
+            k++;
+        }
+        if (name[k] == '\0' && (c[k] == '\0' || c[k] == ' ')) {
+            return &g_modules[i];
+        }
+    }
+    return NULL;
+}
+
+int multiboot2_map_modules(void) {
+    int rc = 0;
+    for (uint32_t i = 0; i < g_module_count; i++) {
+        const mb2_module_t *m = &g_modules[i];
+        if (m->end > m->start && paging_map_identity(m->start, m->end - m->start) != 0) {
+            rc = -1;
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,349 @@
+#include "kernel/paging.h"
+
+#include <stddef.h>
+
+#include "kernel/idt.h"
+#include "kernel/kmem.h"
+#include "kernel/panic.h"
+#include "kernel/serial.h"
+#include "kernel/task.h"
+#include "kernel/util.h"
+
+#define PDE_COUNT 1024u
+#define PAGING_POOL_PAGES 128u
+
+#define CR0_WP (1u << 16)
+#define CR0_PG (1u << 31)
+#define CR4_PSE (1u << 4)
+#define CR4_PGE (1u << 7)
+
+#define CPUID_EDX_PSE (1u << 3)
+#define CPUID_EDX_PGE (1u << 13)
+
+typedef struct {
+    uint32_t *dir;
+    uint32_t *private_table;
+    int user_ready;
+    uint32_t slot_mask;
+} addr_space_info_t;
+
+// Provided by linker.ld: the user image's virtual range and its load address.
+extern uint8_t __user_start[];
+extern uint8_t __user_end[];
+extern uint8_t __user_load[];
+
+static uint32_t g_kernel_dir[PDE_COUNT] __attribute__((aligned(PAGE_SIZE)));
+static uint8_t g_pool[PAGING_POOL_PAGES][PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+static uint32_t g_pool_next = 0;
+
+static addr_space_info_t g_spaces[PAGING_MAX_SPACES];
+static uint32_t g_space_count = 0;
+
+static uint32_t g_kernel_pde_flags = PG_PRESENT | PG_WRITE | PG_LARGE;
+static int g_isolation = 1;
+
+static uint32_t cpuid_features_edx(void) {
+    uint32_t a = 1, b, c, d;
+    __asm__ volatile("cpuid" : "+a"(a), "=b"(b), "=c"(c), "=d"(d));
+    return d;
+}
+
+static void page_fault_handler(interrupt_frame_t *frame) {
+    uint32_t cr2;
+    __asm__ volatile("mov %%cr2, %0" : "=r"(cr2));
+
+    char buf[9];
+    serial_write("PAGE FAULT: addr=0x");
+    u32_to_hex(cr2, buf, sizeof(buf));
+    serial_write(buf);
+    serial_write(" eip=0x");
+    u32_to_hex(frame->eip, buf, sizeof(buf));
+    serial_write(buf);
+    serial_write(" err=0x");
+    u32_to_hex(frame->error, buf, sizeof(buf));
+    serial_write(buf);
+    serial_write(" cr3=0x");
+    u32_to_hex(paging_read_cr3(), buf, sizeof(buf));
+    serial_write(buf);
+    serial_write(" task=");
+    int tid = task_get_current();
+    if (tid >= 0) {
+        uint_to_str((uint32_t)tid, buf, sizeof(buf));
+        serial_write(buf);
+    } else {
+        serial_write("kernel");
+    }
+    serial_write("\n");
+
+    panic("page fault");
+}
+
+void paging_init(void) {
+    uint32_t features = cpuid_features_edx();
+    if (!(features & CPUID_EDX_PSE)) {
+        panic("paging: CPU lacks PSE (4 MB pages)");
+    }
+
+    uint32_t cr4;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+    cr4 |= CR4_PSE;
+    if (features & CPUID_EDX_PGE) {
+        // Global kernel pages survive CR3 reloads on every task switch.
+        cr4 |= CR4_PGE;
+        g_kernel_pde_flags |= PG_GLOBAL;
+    }
+    __asm__ volatile("mov %0, %%cr4" : : "r"(cr4));
+
+    kmemset(g_kernel_dir, 0, sizeof(g_kernel_dir));
+    for (uint32_t addr = 0; addr < PAGING_KERNEL_MAP_BYTES; addr += PAGE_LARGE_SIZE) {
+        g_kernel_dir[addr >> 22] = addr | g_kernel_pde_flags;
+    }
+
+    g_pool_next = 0;
+    g_space_count = 0;
+    g_isolation = 1;
+
+    idt_set_handler(IDT_VEC_PAGE_FAULT, page_fault_handler);
+
+    uint32_t cr0;
+    __asm__ volatile("mov %0, %%cr3" : : "r"((uint32_t)(uintptr_t)g_kernel_dir) : "memory");
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    cr0 |= CR0_PG | CR0_WP;
+    __asm__ volatile("mov %0, %%cr0" : : "r"(cr0) : "memory");
+}
+
+addr_space_t paging_kernel_space(void) {
+    return (addr_space_t)(uintptr_t)g_kernel_dir;
+}
+
+int paging_map_identity(uint32_t paddr, uint32_t len) {
+    if (g_space_count != 0 || len == 0) {
+        return -1;
+    }
+    uint32_t first = paddr >> 22;
+    uint32_t last = (paddr + len - 1) >> 22;
+    if (last < first || last >= (PAGING_PRIVATE_BASE >> 22)) {
+        return -1;
+    }
+    for (uint32_t pde = first; pde <= last; pde++) {
+        if (!(g_kernel_dir[pde] & PG_PRESENT)) {
+            g_kernel_dir[pde] = (pde << 22) | g_kernel_pde_flags;
+        }
+    }
+    return 0;
+}
+
+int paging_is_identity(uint32_t paddr, uint32_t len) {
+    if (len == 0 || paddr + len - 1 < paddr) {
+        return 0;
+    }
+    for (uint32_t pde = paddr >> 22; pde <= (paddr + len - 1) >> 22; pde++) {
+        if ((g_kernel_dir[pde] & (PG_PRESENT | PG_LARGE)) != (PG_PRESENT | PG_LARGE)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void *paging_alloc_frame(void) {
+    return paging_alloc_frames(1);
+}
+
+void *paging_alloc_frames(uint32_t count) {
+    if (count == 0 || count > PAGING_POOL_PAGES - g_pool_next) {
+        return NULL;
+    }
+
+    uint32_t *frames = (uint32_t *)g_pool[g_pool_next];
+    g_pool_next += count;
+    kmemset(frames, 0, count * PAGE_SIZE);
+    return frames;
+}
+
+void paging_free_frames(void *frames, uint32_t count) {
+    if (frames != NULL && count <= g_pool_next && (uint8_t *)frames == g_pool[g_pool_next - count]) {
+        g_pool_next -= count;
+    }
+}
+
+void paging_pool_stats(uint32_t *used, uint32_t *total) {
+    if (used) {
+        *used = g_pool_next;
+    }
+    if (total) {
+        *total = PAGING_POOL_PAGES;
+    }
+}
+
+addr_space_t paging_space_create(void) {
+    if (g_space_count >= PAGING_MAX_SPACES) {
+        return 0;
+    }
+
+    uint32_t *dir = paging_alloc_frame();
+    uint32_t *table = paging_alloc_frame();
+    if (!dir || !table) {
+        return 0;
+    }
+
+    kmemcpy(dir, g_kernel_dir, PDE_COUNT * sizeof(uint32_t));
+    // U/S on the PDE lets individual PTEs decide whether ring 3 may touch them.
+    dir[PAGING_PRIVATE_BASE >> 22] = (uint32_t)(uintptr_t)table | PG_PRESENT | PG_WRITE | PG_USER;
+
+    g_spaces[g_space_count].dir = dir;
+    g_spaces[g_space_count].private_table = table;
+    g_spaces[g_space_count].user_ready = 0;
+    g_spaces[g_space_count].slot_mask = 0;
+    g_space_count++;
+
+    return (addr_space_t)(uintptr_t)dir;
+}
+
+static addr_space_info_t *find_space(addr_space_t space) {
+    for (uint32_t i = 0; i < g_space_count; i++) {
+        if ((addr_space_t)(uintptr_t)g_spaces[i].dir == space) {
+            return &g_spaces[i];
+        }
+    }
+    return NULL;
+}
+
+int paging_map_private(addr_space_t space, uint32_t vaddr, uint32_t paddr, uint32_t flags) {
+    addr_space_info_t *s = find_space(space);
+    if (!s) {
+        return -1;
+    }
+    if (vaddr < PAGING_PRIVATE_BASE || vaddr - PAGING_PRIVATE_BASE >= PAGING_PRIVATE_SIZE) {
+        return -1;
+    }
+    if ((vaddr | paddr) & (PAGE_SIZE - 1)) {
+        return -1;
+    }
+
+    uint32_t idx = (vaddr - PAGING_PRIVATE_BASE) / PAGE_SIZE;
+    s->private_table[idx] = paddr | (flags & (PG_WRITE | PG_USER)) | PG_PRESENT;
+
+    if (paging_read_cr3() == space) {
+        __asm__ volatile("invlpg (%0)" : : "r"(vaddr) : "memory");
+    }
+    return 0;
+}
+
+void paging_unmap_private(addr_space_t space, uint32_t vaddr) {
+    addr_space_info_t *s = find_space(space);
+    if (!s || vaddr < PAGING_PRIVATE_BASE || vaddr - PAGING_PRIVATE_BASE >= PAGING_PRIVATE_SIZE) {
+        return;
+    }
+
+    s->private_table[(vaddr - PAGING_PRIVATE_BASE) / PAGE_SIZE] = 0;
+    if (paging_read_cr3() == space) {
+        __asm__ volatile("invlpg (%0)" : : "r"(vaddr) : "memory");
+    }
+}
+
+uint32_t paging_slot_alloc(addr_space_t space) {
+    addr_space_info_t *s = find_space(space);
+    if (!s) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < PAGING_SLOT_COUNT; i++) {
+        if (!(s->slot_mask & (1u << i))) {
+            s->slot_mask |= 1u << i;
+            return PAGING_SLOT_BASE + i * PAGING_SLOT_PAGES * PAGE_SIZE;
+        }
+    }
+    return 0;
+}
+
+void paging_slot_free(addr_space_t space, uint32_t vaddr) {
+    addr_space_info_t *s = find_space(space);
+    if (!s || vaddr < PAGING_SLOT_BASE) {
+        return;
+    }
+    uint32_t idx = (vaddr - PAGING_SLOT_BASE) / (PAGING_SLOT_PAGES * PAGE_SIZE);
+    if (idx < PAGING_SLOT_COUNT) {
+        s->slot_mask &= ~(1u << idx);
+    }
+}
+
+int paging_translate(addr_space_t space, uint32_t vaddr, uint32_t *paddr, uint32_t *flags) {
+    if (paging_is_identity(vaddr, 1)) {
+        *paddr = vaddr;
+        *flags = PG_PRESENT | PG_WRITE;
+        return 0;
+    }
+
+    addr_space_info_t *s = find_space(space);
+    if (!s || vaddr < PAGING_PRIVATE_BASE || vaddr - PAGING_PRIVATE_BASE >= PAGING_PRIVATE_SIZE) {
+        return -1;
+    }
+    uint32_t pte = s->private_table[(vaddr - PAGING_PRIVATE_BASE) / PAGE_SIZE];
+    if (!(pte & PG_PRESENT)) {
+        return -1;
+    }
+    *paddr = (pte & ~(PAGE_SIZE - 1)) | (vaddr & (PAGE_SIZE - 1));
+    *flags = pte & (PAGE_SIZE - 1);
+    return 0;
+}
+
+int paging_space_setup_user(addr_space_t space) {
+    addr_space_info_t *s = find_space(space);
+    if (!s) {
+        return -1;
+    }
+    if (s->user_ready) {
+        return 0;
+    }
+
+    uint32_t vstart = (uint32_t)(uintptr_t)__user_start;
+    uint32_t vend = (uint32_t)(uintptr_t)__user_end;
+    uint32_t pstart = (uint32_t)(uintptr_t)__user_load;
+    for (uint32_t off = 0; vstart + off < vend; off += PAGE_SIZE) {
+        if (paging_map_private(space, vstart + off, pstart + off, PG_USER) != 0) {
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 1; i <= PAGING_USER_STACK_PAGES; i++) {
+        void *frame = paging_alloc_frame();
+        if (!frame) {
+            return -1;
+        }
+        uint32_t vaddr = PAGING_USER_STACK_TOP - i * PAGE_SIZE;
+        if (paging_map_private(space, vaddr, (uint32_t)(uintptr_t)frame, PG_USER | PG_WRITE) != 0) {
+            return -1;
+        }
+    }
+
+    s->user_ready = 1;
+    return 0;
+}
+
+int paging_user_range_ok(addr_space_t space, uint32_t vaddr, uint32_t len, int write) {
+    addr_space_info_t *s = find_space(space);
+    if (!s || len == 0) {
+        return 0;
+    }
+    if (len > PAGING_PRIVATE_SIZE || vaddr < PAGING_PRIVATE_BASE ||
+        vaddr - PAGING_PRIVATE_BASE > PAGING_PRIVATE_SIZE - len) {
+        return 0;
+    }
+
+    uint32_t need = PG_PRESENT | PG_USER | (write ? PG_WRITE : 0u);
+    uint32_t first = (vaddr - PAGING_PRIVATE_BASE) / PAGE_SIZE;
+    uint32_t last = (vaddr + len - 1 - PAGING_PRIVATE_BASE) / PAGE_SIZE;
+    for (uint32_t i = first; i <= last; i++) {
+        if ((s->private_table[i] & need) != need) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void paging_set_isolation(int enabled) {
+    g_isolation = enabled ? 1 : 0;
+}
+
+int paging_isolation_enabled(void) {
+    return g_isolation;
+}
@@ -20,6 +20,7 @@ void panic(const char *msg) {
         // We're in a task - terminate only this task.
         serial_write("PANIC: Task context detected - terminating task\n");
         vga_set_color(VGA_COLOR_WHITE, VGA_COLOR_BLUE);
+        task_report_fault(current_task);
         task_exit_current();
         for (;;) {
             task_yield();
@@ -28,6 +29,7 @@ void panic(const char *msg) {
     
     // Not in a task - this is a kernel panic, halt the system
     serial_write("PANIC: Kernel panic - halting system\n");
+    serial_flush();
     for (;;) {
         __asm__ volatile ("cli; hlt");
     }
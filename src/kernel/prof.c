@@ -0,0 +1,146 @@
+#include "kernel/prof.h"
+
+#include <stddef.h>
+
+#include "kernel/io.h"
+#include "kernel/irq.h"
+#include "kernel/kprintf.h"
+#include "kernel/serial.h"
+#include "kernel/task.h"
+
+#define PIT_HZ       1193182u
+#define PIT_CH0_DATA 0x40
+#define PIT_CMD      0x43
+
+// Frame pointers are only followed inside the kernel image (stacks live in
+// its .bss), which every address space maps.
+#define PROF_FP_LOW 0x100000u
+
+extern uint8_t __kernel_end[];
+
+typedef struct {
+    uint32_t pc;
+    int16_t task;
+    uint8_t ring;
+    uint8_t depth;
+    uint32_t stack[PROF_MAX_DEPTH];
+} prof_sample_t;
+
+static prof_sample_t g_ring[PROF_RING_SIZE];
+static uint32_t g_head;
+static uint32_t g_count;
+static uint32_t g_overwritten;
+static uint32_t g_ticks;
+static uint32_t g_every = 1;
+static uint32_t g_countdown;
+static int g_running;
+
+static uint8_t walk_frames(uint32_t fp, uint32_t *out) {
+    uint32_t high = (uint32_t)(uintptr_t)__kernel_end - 2u * sizeof(uint32_t);
+    uint8_t depth = 0;
+    while (depth < PROF_MAX_DEPTH && fp >= PROF_FP_LOW && fp <= high && (fp & 3u) == 0) {
+        const uint32_t *frame = (const uint32_t *)(uintptr_t)fp;
+        if (frame[1] == 0) {
+            break;
+        }
+        out[depth++] = frame[1];
+        // Frames only grow towards the stack base; anything else is garbage.
+        if (frame[0] <= fp) {
+            break;
+        }
+        fp = frame[0];
+    }
+    return depth;
+}
+
+static void prof_irq(interrupt_frame_t *frame) {
+    g_ticks++;
+    if (--g_countdown != 0) {
+        return;
+    }
+    g_countdown = g_every;
+
+    prof_sample_t *s = &g_ring[g_head];
+    g_head = (g_head + 1u) % PROF_RING_SIZE;
+    if (g_count < PROF_RING_SIZE) {
+        g_count++;
+    } else {
+        g_overwritten++;
+    }
+    s->pc = frame->eip;
+    s->task = (int16_t)task_get_current();
+    s->ring = (uint8_t)(frame->cs & 3u);
+    s->depth = s->ring == 0 ? walk_frames(frame->ebp, s->stack) : 0;
+}
+
+void prof_start(uint32_t every) {
+    uint32_t flags = irq_save();
+    g_head = 0;
+    g_count = 0;
+    g_overwritten = 0;
+    g_ticks = 0;
+    g_every = every ? every : 1u;
+    g_countdown = g_every;
+    g_running = 1;
+
+    uint32_t divisor = PIT_HZ / PROF_TIMER_HZ;
+    outb(PIT_CMD, 0x34); // channel 0, lobyte/hibyte, mode 2 (rate generator)
+    outb(PIT_CH0_DATA, (uint8_t)(divisor & 0xFF));
+    outb(PIT_CH0_DATA, (uint8_t)(divisor >> 8));
+    irq_set_handler(IRQ_TIMER, prof_irq);
+    irq_restore(flags);
+}
+
+void prof_stop(void) {
+    irq_mask(IRQ_TIMER);
+    g_running = 0;
+}
+
+void prof_get_stats(prof_stats_t *out) {
+    uint32_t flags = irq_save();
+    out->running = g_running;
+    out->every = g_every;
+    out->ticks = g_ticks;
+    out->samples = g_count;
+    out->overwritten = g_overwritten;
+    irq_restore(flags);
+}
+
+// Serial only, with interrupts off so a full transmit ring is drained by
+// polling instead of dropping lines.
+static void dump_line(const char *line) {
+    uint32_t flags = irq_save();
+    serial_write(line);
+    irq_restore(flags);
+}
+
+void prof_dump(void) {
+    char line[160];
+    prof_stop();
+
+    ksnprintf(line, sizeof(line), "@prof-begin hz=%u every=%u samples=%u overwritten=%u\n", PROF_TIMER_HZ, g_every,
+              g_count, g_overwritten);
+    dump_line(line);
+    for (int i = 0; i < MAX_TASKS; i++) {
+        task_info_t info;
+        if (task_get_info(i, &info) == 0 && info.name != NULL) {
+            ksnprintf(line, sizeof(line), "@prof-task id=%d name=%s\n", i, info.name);
+            dump_line(line);
+        }
+    }
+
+    uint32_t first = (g_head + PROF_RING_SIZE - g_count) % PROF_RING_SIZE;
+    for (uint32_t i = 0; i < g_count; i++) {
+        const prof_sample_t *s = &g_ring[(first + i) % PROF_RING_SIZE];
+        int len = ksnprintf(line, sizeof(line), "@prof task=%d ring=%u pc=%08x stack=", s->task, s->ring, s->pc);
+        for (uint8_t d = 0; d < s->depth && len > 0 && (size_t)len < sizeof(line); d++) {
+            len += ksnprintf(line + len, sizeof(line) - (size_t)len, d ? ",%08x" : "%08x", s->stack[d]);
+        }
+        if (len > 0 && (size_t)len + 2u <= sizeof(line)) {
+            line[len] = '\n';
+            line[len + 1] = '\0';
+        }
+        dump_line(line);
+    }
+    dump_line("@prof-end\n");
+}
@@ -3,8 +3,22 @@
 #include <stdint.h>
 
 #include "kernel/io.h"
+#include "kernel/irq.h"
 
 #define COM1 0x3F8
+#define SERIAL_FIFO_DEPTH 16u
+
+static uint32_t g_fifo_depth = 1;
+static uint32_t g_burst = 1; // bytes written per THRE poll / interrupt
+
+// Transmit ring drained by IRQ4 once serial_start_async() has run.
+static uint8_t g_tx_ring[SERIAL_TX_RING_SIZE];
+static volatile uint32_t g_tx_head;
+static volatile uint32_t g_tx_tail;
+static volatile uint32_t g_tx_dropped;
+static volatile int g_tx_active; // FIFO loaded, a THRE interrupt is due
+static int g_tx_async;
+static int g_tx_irq_installed;
 
 static int serial_received(void) {
     return inb(COM1 + 5) & 0x01;
@@ -22,25 +36,161 @@ void serial_init(void) {
     outb(COM1 + 3, 0x03); // 8 bits, no parity, one stop bit
     outb(COM1 + 2, 0xC7); // Enable FIFO, clear, 14-byte threshold
     outb(COM1 + 4, 0x0B); // IRQs enabled, RTS/DSR set
+
+    // IIR bits 7:6 read back 11 only on a 16550A with a working FIFO.
+    g_fifo_depth = ((inb(COM1 + 2) & 0xC0) == 0xC0) ? SERIAL_FIFO_DEPTH : 1u;
+    g_burst = g_fifo_depth;
 }
 
-static void serial_putc(char c) {
+void serial_set_fifo_burst(int enabled) {
+    g_burst = enabled ? g_fifo_depth : 1u;
+}
+
+// THRE set means the whole transmit FIFO is empty, so one poll buys room
+// for a full burst instead of a single byte.
+static void serial_tx_burst(const uint8_t *buf, uint32_t n) {
     while (!serial_is_transmit_empty()) {
         /* spin */
     }
-    outb(COM1, (uint8_t)c);
+    for (uint32_t i = 0; i < n; i++) {
+        outb(COM1, buf[i]);
+    }
 }
 
-void serial_write(const char *s) {
+static void serial_write_polled(const char *s, size_t len) {
+    uint8_t chunk[SERIAL_FIFO_DEPTH];
+    uint32_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '\n') {
+            chunk[n++] = '\r';
+            if (n == g_burst) {
+                serial_tx_burst(chunk, n);
+                n = 0;
+            }
+        }
+        chunk[n++] = (uint8_t)s[i];
+        if (n == g_burst) {
+            serial_tx_burst(chunk, n);
+            n = 0;
+        }
+    }
+    if (n > 0) {
+        serial_tx_burst(chunk, n);
+    }
+}
+
+// Move up to one burst from the ring into the (empty) transmit FIFO.
+// Caller holds interrupts off. Returns the number of bytes written.
+static uint32_t serial_tx_refill(void) {
+    uint32_t n = 0;
+    while (n < g_burst && g_tx_tail != g_tx_head) {
+        outb(COM1, g_tx_ring[g_tx_tail]);
+        g_tx_tail = (g_tx_tail + 1u) & SERIAL_TX_RING_MASK;
+        n++;
+    }
+    return n;
+}
+
+// IRQ4: IIR read acknowledges the THRE interrupt; the FIFO is empty again.
+static void serial_irq(interrupt_frame_t *frame) {
+    (void)frame;
+    (void)inb(COM1 + 2);
+    if (!serial_is_transmit_empty()) {
+        return;
+    }
+    g_tx_active = serial_tx_refill() > 0;
+}
+
+static void serial_tx_push(uint8_t c, int can_wait) {
+    uint32_t next = (g_tx_head + 1u) & SERIAL_TX_RING_MASK;
+    if (next == g_tx_tail) {
+        if (!can_wait) {
+            g_tx_dropped++;
+            return;
+        }
+        // Interrupts are off in the caller, so IRQ4 cannot drain the ring:
+        // make room by hand instead of losing the byte.
+        while (!serial_is_transmit_empty()) {
+            /* spin */
+        }
+        (void)serial_tx_refill();
+    }
+    g_tx_ring[g_tx_head] = c;
+    g_tx_head = next;
+}
+
+void serial_write_len(const char *s, size_t len) {
     if (!s) {
         return;
     }
-    for (; *s; s++) {
-        if (*s == '\n') {
-            serial_putc('\r');
+    if (!g_tx_async) {
+        serial_write_polled(s, len);
+        return;
+    }
+
+    uint32_t flags = irq_save();
+    int can_wait = !(flags & 0x200u);
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '\n') {
+            serial_tx_push('\r', can_wait);
+        }
+        serial_tx_push((uint8_t)s[i], can_wait);
+    }
+    // Idle transmitter: prime the FIFO; the THRE interrupt takes it from there.
+    if (!g_tx_active && serial_is_transmit_empty()) {
+        g_tx_active = serial_tx_refill() > 0;
+    }
+    irq_restore(flags);
+}
+
+void serial_set_async(int enabled) {
+    if (!enabled) {
+        serial_flush();
+        g_tx_async = 0;
+        return;
+    }
+    uint32_t flags = irq_save();
+    if (!g_tx_irq_installed) {
+        irq_set_handler(IRQ_COM1, serial_irq);
+        outb(COM1 + 1, 0x02); // THRE interrupt only; RX stays polled
+        g_tx_irq_installed = 1;
+    }
+    g_tx_async = 1;
+    irq_restore(flags);
+}
+
+void serial_flush(void) {
+    uint32_t flags = irq_save();
+    while (g_tx_tail != g_tx_head) {
+        while (!serial_is_transmit_empty()) {
+            /* spin */
         }
-        serial_putc(*s);
+        (void)serial_tx_refill();
+    }
+    g_tx_active = 0;
+    irq_restore(flags);
+}
+
+void serial_tx_stats(uint32_t *queued, uint32_t *dropped) {
+    uint32_t flags = irq_save();
+    if (queued) {
+        *queued = (g_tx_head - g_tx_tail) & SERIAL_TX_RING_MASK;
+    }
+    if (dropped) {
+        *dropped = g_tx_dropped;
+    }
+    irq_restore(flags);
+}
+
+void serial_write(const char *s) {
+    if (!s) {
+        return;
+    }
+    size_t len = 0;
+    while (s[len] != '\0') {
+        len++;
     }
+    serial_write_len(s, len);
 }
 
 char serial_read_blocking(void) {
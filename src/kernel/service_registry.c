@@ -1,10 +1,28 @@
 #include "kernel/service_registry.h"
-#include "kernel/serial.h"
-#include "kernel/vga.h"
+#include "kernel/klog.h"
+#include "kernel/kprintf.h"
+#include "kernel/util.h"
 #include <stddef.h>
 
-// Global service registry
-static service_entry_t services[SERVICE_MAX_ENTRIES];
+// Power of two, at least twice SERVICE_MAX_ENTRIES to keep probe chains short.
+#define SERVICE_BUCKETS 32u
+
+typedef struct {
+    char name[SERVICE_MAX_NAME_LEN];
+    uint32_t hash;
+    uint16_t version;
+    uint8_t used;
+    uint8_t count;
+    endpoint_id_t instances[SERVICE_MAX_INSTANCES];
+    service_start_fn_t start; // lazy service not started yet
+} service_name_t;
+
+// Global service registry. Interned names are never removed, only emptied.
+static service_name_t table[SERVICE_BUCKETS];
+static uint32_t name_count = 0;
+static endpoint_id_t subscribers[SERVICE_MAX_SUBSCRIBERS];
+static service_balance_t balance = SERVICE_BALANCE_LEAST_QUEUE;
+static uint32_t rr_cursor = 0;
 
 // String comparison helper
 static int str_cmp(const char *a, const char *b) {
@@ -26,63 +44,314 @@ static void str_copy(char *dst, const char *src, size_t max_len) {
     dst[i] = '\0';
 }
 
+uint32_t service_name_hash(const char *name) {
+    return str_hash(name);
+}
+
+// Slot holding name, or -1. The full compare only runs on a hash match.
+static int find_slot(const char *name, uint32_t hash) {
+    for (uint32_t n = 0; n < SERVICE_BUCKETS; n++) {
+        uint32_t i = (hash + n) & (SERVICE_BUCKETS - 1u);
+        if (!table[i].used) {
+            return -1;
+        }
+        if (table[i].hash == hash && str_cmp(table[i].name, name)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int intern(const char *name, uint32_t hash) {
+    int slot = find_slot(name, hash);
+    if (slot >= 0 || name_count >= SERVICE_MAX_ENTRIES) {
+        return slot;
+    }
+    for (uint32_t n = 0; n < SERVICE_BUCKETS; n++) {
+        uint32_t i = (hash + n) & (SERVICE_BUCKETS - 1u);
+        if (!table[i].used) {
+            str_copy(table[i].name, name, SERVICE_MAX_NAME_LEN);
+            table[i].hash = hash;
+            table[i].version = 0;
+            table[i].count = 0;
+            table[i].start = NULL;
+            table[i].used = 1;
+            name_count++;
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static service_handle_t make_handle(int slot) {
+    return (service_handle_t)slot | ((service_handle_t)table[slot].version << 16);
+}
+
+static void notify_rebound(int slot) {
+    ipc_msg_t msg;
+    msg.type = MSG_SERVICE_REBOUND;
+    msg.sender = ENDPOINT_INVALID;
+    msg.payload_len = sizeof(service_rebound_t);
+    service_rebound_t *ev = (service_rebound_t *)msg.payload;
+    ev->handle = make_handle(slot);
+    ev->instances = table[slot].count;
+    for (int i = 0; i < SERVICE_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i] != ENDPOINT_INVALID) {
+            (void)ipc_send(subscribers[i], &msg);
+        }
+    }
+}
+
 void service_registry_init(void) {
-    for (int i = 0; i < SERVICE_MAX_ENTRIES; i++) {
-        services[i].active = 0;
-        services[i].name[0] = '\0';
-        services[i].endpoint = ENDPOINT_INVALID;
+    for (uint32_t i = 0; i < SERVICE_BUCKETS; i++) {
+        table[i].used = 0;
+        table[i].count = 0;
+        table[i].start = NULL;
+        table[i].name[0] = '\0';
     }
+    for (int i = 0; i < SERVICE_MAX_SUBSCRIBERS; i++) {
+        subscribers[i] = ENDPOINT_INVALID;
+    }
+    name_count = 0;
 }
 
 int service_register(const char *name, endpoint_id_t endpoint) {
+    return service_register_hashed(name, service_name_hash(name), endpoint);
+}
+
+int service_register_hashed(const char *name, uint32_t hash, endpoint_id_t endpoint) {
     if (!name || endpoint == ENDPOINT_INVALID) {
         return -1;
     }
-    
-    // Find free slot
-    for (int i = 0; i < SERVICE_MAX_ENTRIES; i++) {
-        if (!services[i].active) {
-            str_copy(services[i].name, name, SERVICE_MAX_NAME_LEN);
-            services[i].endpoint = endpoint;
-            services[i].active = 1;
+
+    int slot = intern(name, hash);
+    if (slot < 0) {
+        return -1; // No free slots
+    }
+    service_name_t *s = &table[slot];
+    if (s->count >= SERVICE_MAX_INSTANCES) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < s->count; i++) {
+        if (s->instances[i] == endpoint) {
+            return -1; // already an instance of this name
+        }
+    }
+
+    s->instances[s->count++] = endpoint;
+    s->version++;
+    notify_rebound(slot);
+    return 0;
+}
+
+int service_unregister(const char *name, endpoint_id_t endpoint) {
+    if (!name) {
+        return -1;
+    }
+
+    int slot = find_slot(name, service_name_hash(name));
+    if (slot < 0) {
+        return -1;
+    }
+    service_name_t *s = &table[slot];
+    for (uint32_t i = 0; i < s->count; i++) {
+        if (s->instances[i] == endpoint) {
+            s->instances[i] = s->instances[--s->count];
+            s->version++;
+            notify_rebound(slot);
             return 0;
         }
     }
-    
-    return -1; // No free slots
+
+    return -1;
+}
+
+static void start_lazy(service_name_t *s) {
+    service_start_fn_t start = s->start;
+    if (start == NULL) {
+        return;
+    }
+    s->start = NULL;
+    for (uint32_t i = 0; i < s->count; i++) {
+        ipc_set_send_hook(s->instances[i], NULL);
+    }
+    if (start() != 0) {
+        klog(KLOG_ERROR, "registry: lazy start of '%s' failed", s->name);
+    }
+}
+
+// First message to an endpoint of a lazy service.
+static void lazy_send_hook(endpoint_id_t ep) {
+    for (uint32_t i = 0; i < SERVICE_BUCKETS; i++) {
+        for (uint32_t j = 0; table[i].used && j < table[i].count; j++) {
+            if (table[i].instances[j] == ep) {
+                start_lazy(&table[i]);
+                return;
+            }
+        }
+    }
+}
+
+int service_set_lazy(const char *name, service_start_fn_t start) {
+    int slot = name ? find_slot(name, service_name_hash(name)) : -1;
+    if (slot < 0 || start == NULL) {
+        return -1;
+    }
+    service_name_t *s = &table[slot];
+    s->start = start;
+    for (uint32_t i = 0; i < s->count; i++) {
+        ipc_set_send_hook(s->instances[i], lazy_send_hook);
+    }
+    return 0;
+}
+
+int service_is_pending(const char *name) {
+    int slot = name ? find_slot(name, service_name_hash(name)) : -1;
+    return slot >= 0 && table[slot].start != NULL;
+}
+
+// Rotate the scan start so ties (and round-robin) spread over instances.
+// A lazy service is started here, on its first lookup.
+static endpoint_id_t pick_instance(service_name_t *s) {
+    start_lazy(s);
+    if (s->count == 0) {
+        return ENDPOINT_INVALID;
+    }
+    uint32_t start = rr_cursor++ % s->count;
+    if (balance == SERVICE_BALANCE_ROUND_ROBIN) {
+        return s->instances[start];
+    }
+
+    endpoint_id_t best = ENDPOINT_INVALID;
+    uint32_t best_depth = 0;
+    for (uint32_t n = 0; n < s->count; n++) {
+        endpoint_id_t ep = s->instances[(start + n) % s->count];
+        uint32_t depth = ipc_queue_depth(ep);
+        if (best == ENDPOINT_INVALID || depth < best_depth) {
+            best = ep;
+            best_depth = depth;
+        }
+    }
+    return best;
 }
 
 endpoint_id_t service_lookup(const char *name) {
+    return service_lookup_hashed(name, service_name_hash(name));
+}
+
+endpoint_id_t service_lookup_hashed(const char *name, uint32_t hash) {
     if (!name) {
         return ENDPOINT_INVALID;
     }
-    
-    for (int i = 0; i < SERVICE_MAX_ENTRIES; i++) {
-        if (services[i].active && str_cmp(services[i].name, name)) {
-            return services[i].endpoint;
+
+    int slot = find_slot(name, hash);
+    return slot < 0 ? ENDPOINT_INVALID : pick_instance(&table[slot]);
+}
+
+service_handle_t service_resolve(const char *name) {
+    return service_resolve_hashed(name, service_name_hash(name));
+}
+
+service_handle_t service_resolve_hashed(const char *name, uint32_t hash) {
+    if (!name) {
+        return SERVICE_HANDLE_INVALID;
+    }
+    int slot = find_slot(name, hash);
+    return slot < 0 ? SERVICE_HANDLE_INVALID : make_handle(slot);
+}
+
+endpoint_id_t service_handle_lookup(service_handle_t *h, const char *name, int *rebound) {
+    if (!h) {
+        return ENDPOINT_INVALID;
+    }
+    if (*h == SERVICE_HANDLE_INVALID) {
+        *h = service_resolve(name);
+        if (*h == SERVICE_HANDLE_INVALID) {
+            return ENDPOINT_INVALID;
+        }
+    }
+
+    uint32_t slot = SERVICE_HANDLE_SLOT(*h);
+    if (slot >= SERVICE_BUCKETS || !table[slot].used) {
+        return ENDPOINT_INVALID;
+    }
+    if (SERVICE_HANDLE_VERSION(*h) != table[slot].version) {
+        *h = make_handle((int)slot);
+        if (rebound) {
+            *rebound = 1;
+        }
+    }
+    return pick_instance(&table[slot]);
+}
+
+// Entry behind a handle (any version), or NULL.
+static service_name_t *handle_entry(service_handle_t h) {
+    uint32_t slot = SERVICE_HANDLE_SLOT(h);
+    if (h == SERVICE_HANDLE_INVALID || slot >= SERVICE_BUCKETS || !table[slot].used) {
+        return NULL;
+    }
+    return &table[slot];
+}
+
+const char *service_handle_name(service_handle_t h) {
+    service_name_t *s = handle_entry(h);
+    return s ? s->name : NULL;
+}
+
+int service_handle_instances(service_handle_t h) {
+    service_name_t *s = handle_entry(h);
+    return s ? s->count : 0;
+}
+
+static uint32_t entry_queue_depth(const service_name_t *s) {
+    uint32_t depth = 0;
+    for (uint32_t i = 0; i < s->count; i++) {
+        depth += ipc_queue_depth(s->instances[i]);
+    }
+    return depth;
+}
+
+uint32_t service_handle_queue_depth(service_handle_t h) {
+    service_name_t *s = handle_entry(h);
+    return s ? entry_queue_depth(s) : 0;
+}
+
+int service_instance_count(const char *name) {
+    int slot = find_slot(name, service_name_hash(name));
+    return slot < 0 ? 0 : table[slot].count;
+}
+
+uint32_t service_queue_depth(const char *name) {
+    int slot = find_slot(name, service_name_hash(name));
+    return slot < 0 ? 0 : entry_queue_depth(&table[slot]);
+}
+
+void service_set_balance(service_balance_t policy) {
+    balance = policy;
+}
+
+int service_subscribe(endpoint_id_t ep) {
+    for (int i = 0; i < SERVICE_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i] == ENDPOINT_INVALID) {
+            subscribers[i] = ep;
+            return 0;
         }
     }
-    
-    return ENDPOINT_INVALID;
+    return -1;
 }
 
 void service_list_all(void) {
-    vga_puts("Registered services:\n");
-    serial_write("Registered services:\n");
+    kprintf("Registered services:\n");
     int count = 0;
-    for (int i = 0; i < SERVICE_MAX_ENTRIES; i++) {
-        if (services[i].active) {
-            vga_puts("  - ");
-            vga_puts(services[i].name);
-            vga_puts("\n");
-            serial_write("  - ");
-            serial_write(services[i].name);
-            serial_write("\n");
+    for (uint32_t i = 0; i < SERVICE_BUCKETS; i++) {
+        const service_name_t *s = &table[i];
+        for (uint32_t j = 0; s->used && j < s->count; j++) {
+            kprintf("  - %-10s endpoint %2u  queued %u  (v%u)%s\n", s->name, s->instances[j],
+                    ipc_queue_depth(s->instances[j]), s->version, s->start ? "  lazy, not started" : "");
             count++;
         }
     }
     if (count == 0) {
-        vga_puts("  (none)\n");
-        serial_write("  (none)\n");
+        kprintf("  (none)\n");
     }
 }
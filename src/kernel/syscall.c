@@ -0,0 +1,185 @@
+#include "kernel/syscall.h"
+
+#include <stddef.h>
+
+#include "kernel/gdt.h"
+#include "kernel/grant.h"
+#include "kernel/idt.h"
+#include "kernel/ipc.h"
+#include "kernel/paging.h"
+#include "kernel/task.h"
+
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+
+#define CPUID_EDX_SEP (1u << 11)
+
+extern void sysenter_entry(void);
+extern void int80_entry(void);
+
+static int g_fast_path = 0;
+
+static void wrmsr(uint32_t msr, uint32_t lo, uint32_t hi) {
+    __asm__ volatile("wrmsr" : : "c"(msr), "a"(lo), "d"(hi));
+}
+
+void syscall_init(void) {
+    uint32_t a = 1, b, c, d;
+    __asm__ volatile("cpuid" : "+a"(a), "=b"(b), "=c"(c), "=d"(d));
+
+    idt_set_user_gate(SYSCALL_INT_VECTOR, (uint32_t)(uintptr_t)int80_entry);
+
+    g_fast_path = (d & CPUID_EDX_SEP) ? 1 : 0;
+    if (g_fast_path) {
+        wrmsr(MSR_SYSENTER_CS, GDT_KERNEL_CODE, 0);
+        // Placeholder; sysenter_entry switches to the current task's kernel stack.
+        wrmsr(MSR_SYSENTER_ESP, 0, 0);
+        wrmsr(MSR_SYSENTER_EIP, (uint32_t)(uintptr_t)sysenter_entry, 0);
+    }
+}
+
+int syscall_fast_path_available(void) {
+    return g_fast_path;
+}
+
+static endpoint_id_t hdr_endpoint(uint32_t v) {
+    return v == 0xFFu ? ENDPOINT_INVALID : (endpoint_id_t)v;
+}
+
+// Ring 3 names only its own endpoints: as receiver, as sender and as grant target.
+static int caller_owns(endpoint_id_t ep) {
+    return ipc_endpoint_owned_by(ep, task_get_current());
+}
+
+static uint32_t sys_ipc_send(uint32_t dst, uint32_t user_msg) {
+    if (!paging_user_range_ok(paging_read_cr3(), user_msg, sizeof(ipc_msg_t), 0)) {
+        return (uint32_t)IPC_ERR_INVALID_MSG;
+    }
+
+    ipc_msg_t msg = *(const ipc_msg_t *)(uintptr_t)user_msg;
+    if (msg.payload_len > IPC_MAX_PAYLOAD) {
+        return (uint32_t)IPC_ERR_INVALID_MSG;
+    }
+    if (msg.sender != ENDPOINT_INVALID && !caller_owns(msg.sender)) {
+        return (uint32_t)IPC_ERR_INVALID_MSG;
+    }
+    return (uint32_t)ipc_send(dst, &msg);
+}
+
+static uint32_t sys_ipc_send_short(uint32_t hdr, uint32_t w0, uint32_t w1) {
+    ipc_msg_t msg;
+    msg.type = (msg_type_t)SYSCALL_HDR_TYPE(hdr);
+    msg.sender = hdr_endpoint(SYSCALL_HDR_SENDER(hdr));
+    msg.payload_len = SYSCALL_HDR_LEN(hdr);
+    if (msg.payload_len > SYSCALL_SHORT_MAX) {
+        return (uint32_t)IPC_ERR_INVALID_MSG;
+    }
+    if (msg.sender != ENDPOINT_INVALID && !caller_owns(msg.sender)) {
+        return (uint32_t)IPC_ERR_INVALID_MSG;
+    }
+
+    uint32_t *words = (uint32_t *)msg.payload;
+    words[0] = w0;
+    words[1] = w1;
+    return (uint32_t)ipc_send(hdr_endpoint(SYSCALL_HDR_EP(hdr)), &msg);
+}
+
+static void sys_ipc_recv(syscall_regs_t *r) {
+    endpoint_id_t ep = r->ebx;
+    uint32_t user_buf = r->esi;
+
+    if (!caller_owns(ep)) {
+        r->eax = (uint32_t)IPC_ERR_INVALID_ENDPOINT;
+        return;
+    }
+    // Check the buffer before dequeuing so a bad pointer never loses a message.
+    if (!paging_user_range_ok(paging_read_cr3(), user_buf, sizeof(ipc_msg_t), 1)) {
+        r->eax = (uint32_t)IPC_ERR_INVALID_MSG;
+        return;
+    }
+
+    ipc_msg_t msg;
+    ipc_error_t err = ipc_recv(ep, &msg);
+    r->eax = (uint32_t)err;
+    if (err != IPC_SUCCESS) {
+        return;
+    }
+
+    uint32_t len = msg.payload_len > IPC_MAX_PAYLOAD ? IPC_MAX_PAYLOAD : msg.payload_len;
+    uint32_t sender = msg.sender >= 0xFFu ? 0xFFu : msg.sender;
+    const uint32_t *words = (const uint32_t *)msg.payload;
+    r->ebx = SYSCALL_HDR_PACK(ep, sender, msg.type, len);
+    r->esi = words[0];
+    r->edi = words[1];
+
+    if (len > SYSCALL_SHORT_MAX) {
+        *(ipc_msg_t *)(uintptr_t)user_buf = msg;
+    }
+}
+
+static uint32_t sys_grant_create(uint32_t addr, uint32_t pages_rights, uint32_t target) {
+    uint32_t npages = pages_rights & 0xFFFFu;
+    uint32_t rights = pages_rights >> 16;
+    if (npages == 0 || npages > GRANT_MAX_PAGES) {
+        return (uint32_t)GRANT_INVALID;
+    }
+    // Ring 3 may only share pages it can reach itself.
+    if (!paging_user_range_ok(paging_read_cr3(), addr, npages * PAGE_SIZE, (rights & GRANT_WRITE) != 0)) {
+        return (uint32_t)GRANT_INVALID;
+    }
+    return grant_create((const void *)(uintptr_t)addr, npages, target, rights);
+}
+
+static void sys_grant_map(syscall_regs_t *r) {
+    void *addr = NULL;
+    if (!caller_owns(r->esi) || grant_map(r->ebx, r->esi, r->edi, 1, &addr) != 0) {
+        r->eax = (uint32_t)-1;
+        return;
+    }
+    r->eax = 0;
+    r->ebx = (uint32_t)(uintptr_t)addr;
+}
+
+void syscall_dispatch(syscall_regs_t *r) {
+    switch (r->eax) {
+    case SYS_NULL:
+        r->eax = 0;
+        break;
+    case SYS_YIELD:
+        task_yield();
+        r->eax = 0;
+        break;
+    case SYS_EXIT:
+        task_exit_current();
+        r->eax = 0;
+        break;
+    case SYS_IPC_SEND:
+        r->eax = sys_ipc_send(r->ebx, r->esi);
+        break;
+    case SYS_IPC_SEND_SHORT:
+        r->eax = sys_ipc_send_short(r->ebx, r->esi, r->edi);
+        break;
+    case SYS_IPC_RECV:
+        sys_ipc_recv(r);
+        break;
+    case SYS_BUFFER_ALLOC:
+        r->eax = (uint32_t)(uintptr_t)grant_buffer_alloc(r->ebx, 1);
+        break;
+    case SYS_GRANT_CREATE:
+        r->eax = sys_grant_create(r->ebx, r->esi, r->edi);
+        break;
+    case SYS_GRANT_MAP:
+        sys_grant_map(r);
+        break;
+    case SYS_GRANT_UNMAP:
+        r->eax = caller_owns(grant_target(r->ebx)) ? (uint32_t)grant_unmap(r->ebx) : (uint32_t)-1;
+        break;
+    case SYS_GRANT_REVOKE:
+        r->eax = (uint32_t)grant_revoke(r->ebx);
+        break;
+    default:
+        r->eax = (uint32_t)-1;
+        break;
+    }
+}
@@ -2,15 +2,26 @@
 
 #include <stddef.h>
 
+#include "kernel/fpu.h"
+#include "kernel/gdt.h"
+#include "kernel/grant.h"
+#include "kernel/ipc.h"
+#include "kernel/kmem.h"
+#include "kernel/kstack.h"
+#include "kernel/paging.h"
 #include "kernel/panic.h"
+#include "kernel/serial.h"
+#include "kernel/trace.h"
 
-#define MAX_TASKS 8
-#define STACK_SIZE 4096
+// Painted over the whole stack at (re)start; the bottom word doubles as an
+// overflow check, next to the guard band kstack keeps below each stack.
+#define STACK_CANARY 0x5AC3A55Au
 
 typedef enum {
     TASK_UNUSED = 0,
     TASK_RUNNABLE,
     TASK_FINISHED,
+    TASK_CRASHED, // died with a supervisor attached; held for task_restart
 } task_state_t;
 
 typedef struct {
@@ -18,16 +29,33 @@ typedef struct {
     task_entry_t entry;
     void *arg;
     uint32_t *sp;
+    uint8_t *stack;
+    uint32_t stack_size;
+    int stack_overflow;
+    int claimed;              // the fault hook took charge of a crash
     task_state_t state;
+    uint32_t flags;           // TASK_FLAG_*
+    addr_space_t space;       // CR3 this task runs on
+    addr_space_t own_space;   // page directory owned by this slot (0 = none yet)
+    uint32_t runs;            // times scheduled
+    uint32_t generation;      // bumped whenever the slot starts a task afresh
 } task_t;
 
-extern void ctx_switch(uint32_t **old_sp, uint32_t *new_sp);
+extern void ctx_switch(uint32_t **old_sp, uint32_t *new_sp, uint32_t new_cr3);
+extern void enter_user_mode(uint32_t eip, uint32_t user_esp);
+extern void user_task_exit(void);
 
 static task_t g_tasks[MAX_TASKS];
-static uint8_t g_stacks[MAX_TASKS][STACK_SIZE];
 
 static int g_current = -1;
 static uint32_t *g_scheduler_sp = NULL;
+static addr_space_t g_kernel_space = 0;
+static task_fault_hook_t g_fault_hook = NULL;
+static int g_next_hint = -1;
+
+static uint32_t task_kernel_stack_top(int id) {
+    return (uint32_t)(uintptr_t)(g_tasks[id].stack + g_tasks[id].stack_size) & ~0xFu;
+}
 
 __attribute__((noreturn)) static void task_exit(void) {
     if (g_current >= 0 && g_current < MAX_TASKS) {
@@ -61,6 +89,14 @@ __attribute__((noreturn)) static void task_trampoline(void) {
         panic("task_trampoline: null entry");
     }
 
+    if (t->flags & TASK_FLAG_USER) {
+        // Fresh user stack: arg, then a return address that exits the task.
+        uint32_t *usp = (uint32_t *)PAGING_USER_STACK_TOP;
+        *(--usp) = (uint32_t)(uintptr_t)t->arg;
+        *(--usp) = (uint32_t)(uintptr_t)user_task_exit;
+        enter_user_mode((uint32_t)(uintptr_t)t->entry, (uint32_t)(uintptr_t)usp);
+    }
+
     t->entry(t->arg);
     task_exit();
 }
@@ -71,11 +107,23 @@ void task_init(void) {
         g_tasks[i].entry = NULL;
         g_tasks[i].arg = NULL;
         g_tasks[i].sp = NULL;
+        g_tasks[i].stack = NULL;
+        g_tasks[i].stack_size = 0;
+        g_tasks[i].stack_overflow = 0;
+        g_tasks[i].claimed = 0;
         g_tasks[i].state = TASK_UNUSED;
+        g_tasks[i].flags = 0;
+        g_tasks[i].space = 0;
+        g_tasks[i].own_space = 0;
+        g_tasks[i].runs = 0;
+        g_tasks[i].generation = 0;
     }
+    g_next_hint = -1;
 
     g_current = -1;
     g_scheduler_sp = NULL;
+    g_kernel_space = paging_kernel_space();
+    kstack_init();
 }
 
 static int alloc_task_slot(void) {
@@ -87,27 +135,20 @@ static int alloc_task_slot(void) {
     return -1;
 }
 
-int task_create(const char *name, task_entry_t entry, void *arg) {
-    int id = alloc_task_slot();
-    if (id < 0) {
-        return -1;
-    }
-
-    g_tasks[id].name = name;
-    g_tasks[id].entry = entry;
-    g_tasks[id].arg = arg;
-    g_tasks[id].state = TASK_RUNNABLE;
-
-    // Prepare initial stack so the first context switch "returns" into task_trampoline.
-    uint32_t *stack_top = (uint32_t *)(g_stacks[id] + STACK_SIZE);
+// Prepare initial stack so the first context switch "returns" into task_trampoline.
+static void task_prepare_stack(int id) {
+    kmemset32(g_tasks[id].stack, STACK_CANARY, g_tasks[id].stack_size / sizeof(uint32_t));
+    kstack_guard_reset(g_tasks[id].stack);
+    g_tasks[id].stack_overflow = 0;
+    fpu_task_reset(id);
 
     // Align to 16 bytes for good measure.
-    stack_top = (uint32_t *)((uintptr_t)stack_top & ~((uintptr_t)0xF));
+    uint32_t *stack_top = (uint32_t *)(uintptr_t)task_kernel_stack_top(id);
 
     // Stack layout expected by ctx_switch (top -> bottom):
     // EDI, ESI, EBP, ESP(dummy), EBX, EDX, ECX, EAX, EFLAGS, RET
     *(--stack_top) = (uint32_t)(uintptr_t)task_trampoline; // RET
-    *(--stack_top) = 0x2u; // EFLAGS (IF=0)
+    *(--stack_top) = 0x202u; // EFLAGS (IF=1: device IRQs, no preemption)
     *(--stack_top) = 0; // EAX
     *(--stack_top) = 0; // ECX
     *(--stack_top) = 0; // EDX
@@ -118,6 +159,68 @@ int task_create(const char *name, task_entry_t entry, void *arg) {
     *(--stack_top) = 0; // EDI
 
     g_tasks[id].sp = stack_top;
+}
+
+int task_create(const char *name, task_entry_t entry, void *arg) {
+    return task_create_ex(name, entry, arg, NULL);
+}
+
+int task_create_ex(const char *name, task_entry_t entry, void *arg, const task_attr_t *attr) {
+    int id = alloc_task_slot();
+    if (id < 0) {
+        return -1;
+    }
+
+    uint32_t flags = attr ? attr->flags : 0;
+    uint32_t stack_size = (attr && attr->stack_size) ? attr->stack_size : TASK_STACK_DEFAULT;
+    if (stack_size < TASK_STACK_MIN || stack_size > TASK_STACK_MAX) {
+        return -1;
+    }
+    stack_size = (stack_size + KSTACK_ALIGN - 1) & ~(KSTACK_ALIGN - 1);
+    if (flags & TASK_FLAG_USER) {
+        flags |= TASK_FLAG_ISOLATED;
+    }
+
+    // A slot keeps its page directory once created, so reused slots do not leak spaces.
+    addr_space_t space = g_kernel_space;
+    if (flags & TASK_FLAG_ISOLATED) {
+        if (g_tasks[id].own_space == 0) {
+            g_tasks[id].own_space = paging_space_create();
+        }
+        if (g_tasks[id].own_space == 0) {
+            return -1;
+        }
+        space = g_tasks[id].own_space;
+    }
+    if ((flags & TASK_FLAG_USER) && paging_space_setup_user(space) != 0) {
+        return -1;
+    }
+
+    // A finished slot keeps its stack for task_restart; reuse it if it fits.
+    if (g_tasks[id].stack != NULL && g_tasks[id].stack_size != stack_size) {
+        kstack_free(g_tasks[id].stack);
+        g_tasks[id].stack = NULL;
+    }
+    if (g_tasks[id].stack == NULL) {
+        g_tasks[id].stack = kstack_alloc(stack_size);
+        if (g_tasks[id].stack == NULL) {
+            return -1;
+        }
+        g_tasks[id].stack_size = stack_size;
+    }
+
+    g_tasks[id].name = name;
+    g_tasks[id].entry = entry;
+    g_tasks[id].arg = arg;
+    g_tasks[id].flags = flags;
+    g_tasks[id].space = space;
+    g_tasks[id].claimed = 0;
+    g_tasks[id].generation++;
+    g_tasks[id].state = TASK_RUNNABLE;
+    // Endpoints handed to the slot's previous task are not this one's.
+    ipc_endpoint_disown(id);
+
+    task_prepare_stack(id);
 
     return id;
 }
@@ -127,7 +230,7 @@ void task_yield(void) {
         return;
     }
 
-    ctx_switch(&g_tasks[g_current].sp, g_scheduler_sp);
+    ctx_switch(&g_tasks[g_current].sp, g_scheduler_sp, g_kernel_space);
 }
 
 static int pick_next_runnable(int start_after) {
@@ -144,63 +247,178 @@ void scheduler_run(void) {
     int last = -1;
 
     for (;;) {
-        int next = pick_next_runnable(last);
+        int in_turn = pick_next_runnable(last);
+        int next = in_turn;
+        if (g_next_hint >= 0) {
+            if (g_tasks[g_next_hint].state == TASK_RUNNABLE) {
+                next = g_next_hint;
+            }
+            g_next_hint = -1;
+        }
         if (next < 0) {
             break;
         }
 
-        last = next;
+        // A hinted task runs out of turn; the round-robin order carries on.
+        if (next == in_turn) {
+            last = next;
+        }
         g_current = next;
 
-        // Save scheduler SP and switch to task.
-        ctx_switch(&g_scheduler_sp, g_tasks[next].sp);
+        // Save scheduler SP and switch to task (and its address space).
+        task_t *t = &g_tasks[next];
+        t->runs++;
+        addr_space_t space = t->space;
+        if (!paging_isolation_enabled() && !(t->flags & TASK_FLAG_USER)) {
+            space = g_kernel_space;
+        }
+        if (t->flags & TASK_FLAG_USER) {
+            gdt_set_kernel_stack(task_kernel_stack_top(next));
+        }
+        fpu_switch_to(next);
+        trace(TRACE_SWITCH_IN, (uint32_t)next, t->runs);
+        ctx_switch(&g_scheduler_sp, g_tasks[next].sp, space);
+        // Back in the scheduler loop: samples and log records from here on
+        // belong to no task (prof and klog read task_get_current()).
+        g_current = -1;
+        trace(TRACE_SWITCH_OUT, (uint32_t)next, t->state == TASK_FINISHED);
 
         // When the task yields, we resume here.
+        if (!t->stack_overflow &&
+            (*(const uint32_t *)t->stack != STACK_CANARY || !kstack_guard_intact(t->stack))) {
+            // The task ran past the bottom of its stack, into the guard band
+            // (or, with a big enough frame, past it); stop it before it does
+            // more harm.
+            t->stack_overflow = 1;
+            t->state = TASK_FINISHED;
+            serial_write("TASK: stack overflow in '");
+            serial_write(t->name ? t->name : "?");
+            serial_write("' - terminating task\n");
+            task_report_fault(next);
+        }
         if (g_tasks[next].state == TASK_FINISHED) {
-            g_tasks[next].state = TASK_UNUSED;
+            grant_release_task(next);
+            // A crash the supervisor took charge of keeps the slot out of
+            // task_create until it restarts or releases it. Entry/arg/name
+            // stay either way so the monitor can restart by task id.
+            g_tasks[next].state = t->claimed ? TASK_CRASHED : TASK_UNUSED;
             g_tasks[next].sp = NULL;
-            // Keep entry/arg/name so the monitor can restart by task id.
         }
     }
 
     g_current = -1;
 }
 
+void task_run_next(int task_id) {
+    if (task_id >= 0 && task_id < MAX_TASKS) {
+        g_next_hint = task_id;
+    }
+}
+
+void task_set_fault_hook(task_fault_hook_t hook) {
+    g_fault_hook = hook;
+}
+
+void task_report_fault(int task_id) {
+    if (g_fault_hook != NULL && task_id >= 0 && task_id < MAX_TASKS && g_fault_hook(task_id)) {
+        g_tasks[task_id].claimed = 1;
+    }
+}
+
+int task_get_info(int task_id, task_info_t *out) {
+    if (task_id < 0 || task_id >= MAX_TASKS || !out) {
+        return -1;
+    }
+    task_t *t = &g_tasks[task_id];
+    if (t->stack == NULL) {
+        return -1;
+    }
+
+    // Untouched canary words at the bottom = stack never used.
+    const uint32_t *words = (const uint32_t *)t->stack;
+    uint32_t count = t->stack_size / sizeof(uint32_t);
+    uint32_t untouched = 0;
+    while (untouched < count && words[untouched] == STACK_CANARY) {
+        untouched++;
+    }
+
+    out->name = t->name;
+    out->running = t->state == TASK_RUNNABLE;
+    out->stack_size = t->stack_size;
+    out->stack_peak = t->stack_size - untouched * (uint32_t)sizeof(uint32_t);
+    out->stack_overflow = t->stack_overflow || (untouched == 0) || !kstack_guard_intact(t->stack);
+    out->runs = t->runs;
+    return 0;
+}
+
+uint32_t task_get_runs(int task_id) {
+    if (task_id < 0 || task_id >= MAX_TASKS) {
+        return 0;
+    }
+    return g_tasks[task_id].runs;
+}
+
 int task_get_current(void) {
     return g_current;
 }
 
+uint32_t task_get_generation(int task_id) {
+    if (task_id < 0 || task_id >= MAX_TASKS) {
+        return 0;
+    }
+    return g_tasks[task_id].generation;
+}
+
+int task_kill(int task_id) {
+    if (task_id < 0 || task_id >= MAX_TASKS) {
+        return -1;
+    }
+    if (g_tasks[task_id].state == TASK_CRASHED) {
+        g_tasks[task_id].state = TASK_UNUSED;
+        g_tasks[task_id].entry = NULL;
+        return 0;
+    }
+    if (g_tasks[task_id].state != TASK_RUNNABLE) {
+        return -1;
+    }
+    if (task_id == g_current) {
+        g_tasks[task_id].entry = NULL;
+        task_exit_current();
+        return 0;
+    }
+
+    // Suspended in task_yield: just never switch back. Slot, stack and space stay
+    // with the slot for the next task_create.
+    grant_release_task(task_id);
+    g_tasks[task_id].state = TASK_UNUSED;
+    g_tasks[task_id].sp = NULL;
+    g_tasks[task_id].entry = NULL;
+    return 0;
+}
+
 int task_restart(int task_id) {
     if (task_id < 0 || task_id >= MAX_TASKS) {
         return -1;
     }
 
     task_t *t = &g_tasks[task_id];
-    
-    // Can only restart if we have the original entry point
-    if (t->entry == NULL) {
+
+    // Only a live (e.g. hung) task or a held crash: an unused slot may since
+    // have been handed to another task, or may get one any time.
+    if (t->entry == NULL || (t->state != TASK_RUNNABLE && t->state != TASK_CRASHED)) {
         return -1;
     }
 
-    // Reset the task state
-    t->state = TASK_RUNNABLE;
-
-    // Prepare new stack (same as task_create)
-    uint32_t *stack_top = (uint32_t *)(g_stacks[task_id] + STACK_SIZE);
-    stack_top = (uint32_t *)((uintptr_t)stack_top & ~((uintptr_t)0xF));
+    trace(TRACE_TASK_RESTART, (uint32_t)task_id, 0);
 
-    *(--stack_top) = (uint32_t)(uintptr_t)task_trampoline; // RET
-    *(--stack_top) = 0x2u; // EFLAGS (IF=0)
-    *(--stack_top) = 0; // EAX
-    *(--stack_top) = 0; // ECX
-    *(--stack_top) = 0; // EDX
-    *(--stack_top) = 0; // EBX
-    *(--stack_top) = 0; // ESP (ignored by popad)
-    *(--stack_top) = 0; // EBP
-    *(--stack_top) = 0; // ESI
-    *(--stack_top) = 0; // EDI
+    // Reset the task state; the slot keeps its address space, but not what the
+    // old instance shared or mapped.
+    grant_release_task(task_id);
+    t->state = TASK_RUNNABLE;
+    t->claimed = 0;
+    t->generation++;
 
-    t->sp = stack_top;
+    task_prepare_stack(task_id);
 
     return 0;
 }
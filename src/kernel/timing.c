@@ -0,0 +1,146 @@
+#include "kernel/timing.h"
+#include "kernel/io.h"
+#include "kernel/util.h"
+
+#define PIT_HZ           1193182u
+#define PIT_CH2_DATA     0x42
+#define PIT_CMD          0x43
+#define PIT_GATE_PORT    0x61
+#define PIT_GATE_CH2     0x01
+#define PIT_SPEAKER      0x02
+#define PIT_OUT2         0x20
+#define PIT_CAL_COUNT    11932u   // ~10 ms
+#define PIT_CAL_RUNS     3
+#define PIT_CAL_SPIN_MAX 50000000u
+
+#define CPUID_EDX_SSE2          (1u << 26)
+#define CPUID_EXT_EDX_RDTSCP    (1u << 27)
+#define CPUID_APM_EDX_INVARIANT (1u << 8)
+
+uint32_t tsc_caps;
+
+static uint32_t g_tsc_khz;
+static uint32_t g_mult;
+static uint32_t g_shift;
+static uint64_t g_tsc_base;
+static const char *g_source = "none";
+
+static void cpuid(uint32_t leaf, uint32_t *a, uint32_t *b, uint32_t *c, uint32_t *d) {
+    __asm__ volatile("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(0));
+}
+
+// TSC kHz from the crystal ratio in leaf 0x15, or 0 when it is not reported.
+static uint32_t calibrate_cpuid(uint32_t max_leaf) {
+    uint32_t den, num, crystal_hz, d;
+    if (max_leaf < 0x15) {
+        return 0;
+    }
+    cpuid(0x15, &den, &num, &crystal_hz, &d);
+    if (den == 0 || num == 0 || crystal_hz == 0) {
+        return 0;
+    }
+    uint64_t hz = u64_div_u32((uint64_t)crystal_hz * num, den, NULL);
+    return (uint32_t)u64_div_u32(hz, 1000u, NULL);
+}
+
+// One PIT channel 2 one-shot, gated through port 0x61 with the speaker off.
+// Returns the TSC cycles it took, or 0 if OUT2 never rose.
+static uint64_t pit_one_shot(void) {
+    uint8_t gate = inb(PIT_GATE_PORT);
+    outb(PIT_GATE_PORT, (uint8_t)((gate & ~PIT_SPEAKER) & ~PIT_GATE_CH2));
+    outb(PIT_CMD, 0xB0);    // channel 2, lobyte/hibyte, mode 0, binary
+    outb(PIT_CH2_DATA, (uint8_t)(PIT_CAL_COUNT & 0xFF));
+    outb(PIT_CH2_DATA, (uint8_t)(PIT_CAL_COUNT >> 8));
+
+    outb(PIT_GATE_PORT, (uint8_t)((gate & ~PIT_SPEAKER) | PIT_GATE_CH2));
+    uint64_t t0 = tsc_read();
+    uint32_t spins = 0;
+    while (!(inb(PIT_GATE_PORT) & PIT_OUT2)) {
+        if (++spins == PIT_CAL_SPIN_MAX) {
+            outb(PIT_GATE_PORT, gate);
+            return 0;
+        }
+    }
+    uint64_t t1 = tsc_read();
+    outb(PIT_GATE_PORT, gate);
+    return t1 - t0;
+}
+
+// Shortest of a few runs, so a host preemption inflates at most one of them.
+static uint32_t calibrate_pit(void) {
+    uint64_t best = 0;
+    for (int i = 0; i < PIT_CAL_RUNS; i++) {
+        uint64_t c = pit_one_shot();
+        if (c != 0 && (best == 0 || c < best)) {
+            best = c;
+        }
+    }
+    if (best == 0) {
+        return 0;
+    }
+    // kHz = cycles * PIT_HZ / (count * 1000)
+    uint64_t scaled = u64_div_u32(best * PIT_HZ, PIT_CAL_COUNT, NULL);
+    return (uint32_t)u64_div_u32(scaled, 1000u, NULL);
+}
+
+void clock_init(void) {
+    uint32_t max_leaf, a, b, c, d;
+    cpuid(0, &max_leaf, &b, &c, &d);
+    cpuid(1, &a, &b, &c, &d);
+    if (d & CPUID_EDX_SSE2) {
+        tsc_caps |= TSC_CAP_LFENCE;
+    }
+    uint32_t max_ext;
+    cpuid(0x80000000u, &max_ext, &b, &c, &d);
+    if (max_ext >= 0x80000001u) {
+        cpuid(0x80000001u, &a, &b, &c, &d);
+        if (d & CPUID_EXT_EDX_RDTSCP) {
+            tsc_caps |= TSC_CAP_RDTSCP;
+        }
+    }
+    if (max_ext >= 0x80000007u) {
+        cpuid(0x80000007u, &a, &b, &c, &d);
+        if (d & CPUID_APM_EDX_INVARIANT) {
+            tsc_caps |= TSC_CAP_INVARIANT;
+        }
+    }
+
+    g_tsc_khz = calibrate_cpuid(max_leaf);
+    g_source = "cpuid 0x15";
+    if (g_tsc_khz == 0) {
+        g_tsc_khz = calibrate_pit();
+        g_source = "pit";
+    }
+    if (g_tsc_khz == 0) {
+        // No usable reference: assume 1 GHz so ns still read as cycles.
+        g_tsc_khz = 1000000u;
+        g_source = "assumed";
+    }
+
+    // Largest shift (<= 32) whose mult = 1e6 * 2^shift / kHz fits 32 bits.
+    g_shift = 32;
+    while (g_shift > 0 && (1000000ull << g_shift) >= (uint64_t)g_tsc_khz << 32) {
+        g_shift--;
+    }
+    g_mult = (uint32_t)u64_div_u32(1000000ull << g_shift, g_tsc_khz, NULL);
+    g_tsc_base = tsc_read();
+}
+
+uint32_t clock_tsc_khz(void) {
+    return g_tsc_khz;
+}
+
+const char *clock_source(void) {
+    return g_source;
+}
+
+// 64x32 multiply split in halves so the 96-bit product never materializes.
+uint64_t clock_cycles_to_ns(uint64_t cycles) {
+    uint64_t lo = (uint64_t)(uint32_t)cycles * g_mult;
+    uint64_t hi = (uint64_t)(uint32_t)(cycles >> 32) * g_mult;
+    return (lo >> g_shift) + (hi << (32 - g_shift));
+}
+
+uint64_t clock_monotonic_ns(void) {
+    return clock_cycles_to_ns(tsc_read() - g_tsc_base);
+}
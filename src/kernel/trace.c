@@ -0,0 +1,99 @@
+#include "kernel/trace.h"
+
+#include <stddef.h>
+
+#include "kernel/irq.h"
+#include "kernel/kprintf.h"
+#include "kernel/serial.h"
+#include "kernel/task.h"
+#include "kernel/timing.h"
+
+int trace_enabled;
+
+static trace_record_t g_ring[TRACE_RING_SIZE];
+static uint32_t g_head;
+static uint32_t g_count;
+static uint32_t g_overwritten;
+
+static const char *const g_event_names[TRACE_EVENT_MAX] = {
+    [TRACE_NONE] = "none",
+    [TRACE_SWITCH_IN] = "switch_in",
+    [TRACE_SWITCH_OUT] = "switch_out",
+    [TRACE_IPC_SEND] = "ipc_send",
+    [TRACE_IPC_RECV] = "ipc_recv",
+    [TRACE_TASK_RESTART] = "task_restart",
+    [TRACE_CRASH] = "crash",
+    [TRACE_SVC_DISPATCH] = "svc_dispatch",
+};
+
+void trace_record(trace_event_t ev, uint32_t a0, uint32_t a1) {
+    uint32_t flags = irq_save();
+    trace_record_t *r = &g_ring[g_head];
+    g_head = (g_head + 1u) % TRACE_RING_SIZE;
+    if (g_count < TRACE_RING_SIZE) {
+        g_count++;
+    } else {
+        g_overwritten++;
+    }
+    r->tsc = tsc_to_u64(tsc_now());
+    r->event = (uint16_t)ev;
+    r->cpu = 0;
+    r->task = (int8_t)task_get_current();
+    r->a0 = a0;
+    r->a1 = a1;
+    irq_restore(flags);
+}
+
+void trace_set_enabled(int enabled) {
+    trace_enabled = enabled != 0;
+}
+
+void trace_clear(void) {
+    uint32_t flags = irq_save();
+    g_head = 0;
+    g_count = 0;
+    g_overwritten = 0;
+    irq_restore(flags);
+}
+
+void trace_get_stats(uint32_t *records, uint32_t *overwritten) {
+    *records = g_count;
+    *overwritten = g_overwritten;
+}
+
+const char *trace_event_name(trace_event_t ev) {
+    return ev < TRACE_EVENT_MAX ? g_event_names[ev] : "?";
+}
+
+// Serial only, with interrupts off so a full transmit ring is drained by
+// polling instead of dropping lines.
+static void dump_line(const char *line) {
+    uint32_t flags = irq_save();
+    serial_write(line);
+    irq_restore(flags);
+}
+
+void trace_dump(void) {
+    char line[128];
+    trace_enabled = 0;
+
+    ksnprintf(line, sizeof(line), "@trace-begin tsc_khz=%u records=%u overwritten=%u\n", clock_tsc_khz(), g_count,
+              g_overwritten);
+    dump_line(line);
+    for (int i = 0; i < MAX_TASKS; i++) {
+        task_info_t info;
+        if (task_get_info(i, &info) == 0 && info.name != NULL) {
+            ksnprintf(line, sizeof(line), "@trace-task id=%d name=%s\n", i, info.name);
+            dump_line(line);
+        }
+    }
+
+    uint32_t first = (g_head + TRACE_RING_SIZE - g_count) % TRACE_RING_SIZE;
+    for (uint32_t i = 0; i < g_count; i++) {
+        const trace_record_t *r = &g_ring[(first + i) % TRACE_RING_SIZE];
+        ksnprintf(line, sizeof(line), "@trace t=%llu cpu=%u task=%d ev=%s a0=%u a1=%u\n", r->tsc, r->cpu, r->task,
+                  trace_event_name((trace_event_t)r->event), r->a0, r->a1);
+        dump_line(line);
+    }
+    dump_line("@trace-end\n");
+}
@@ -55,6 +55,20 @@ size_t u32_to_hex(uint32_t value, char *buf, size_t buf_size) {
     return 8;
 }
 
+uint64_t u64_div_u32(uint64_t n, uint32_t d, uint32_t *rem) {
+    uint32_t hi = (uint32_t)(n >> 32);
+    uint32_t lo = (uint32_t)n;
+    uint32_t q_hi = hi / d;
+    uint32_t r = hi % d;
+    uint32_t q_lo;
+    // r < d, so (r:lo) / d fits in 32 bits.
+    __asm__("divl %4" : "=a"(q_lo), "=d"(r) : "a"(lo), "d"(r), "rm"(d));
+    if (rem) {
+        *rem = r;
+    }
+    return ((uint64_t)q_hi << 32) | q_lo;
+}
+
 size_t str_len(const char *s) {
     if (!s) {
         return 0;
@@ -66,6 +80,14 @@ size_t str_len(const char *s) {
     return len;
 }
 
+uint32_t str_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    for (; s && *s; s++) {
+        h = (h ^ (uint8_t)*s) * 16777619u;
+    }
+    return h;
+}
+
 void str_copy_safe(char *dst, const char *src, size_t dst_size) {
     if (!dst || dst_size == 0) {
         return;
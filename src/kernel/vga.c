@@ -1,11 +1,20 @@
 #include "kernel/vga.h"
+#include "kernel/kmem.h"
 
 #include <stddef.h>
 #include <stdint.h>
 
 static volatile uint16_t *const VGA_BUFFER = (uint16_t *)0xB8000;
-static const size_t VGA_WIDTH = 80;
-static const size_t VGA_HEIGHT = 25;
+
+// RAM shadow of the screen plus scrollback. Rows form a ring: the live screen
+// is VGA_HEIGHT rows starting at g_top, so scrolling only moves g_top.
+#define VGA_HISTORY_ROWS (VGA_HEIGHT * VGA_SCROLLBACK_PAGES)
+
+static uint16_t g_rows[VGA_HISTORY_ROWS][VGA_WIDTH];
+static size_t g_top;       // ring index of screen row 0
+static size_t g_scrolled;  // rows pushed into history, capped at the ring size
+static size_t g_view;      // rows the display is scrolled back from live
+static uint32_t g_dirty;   // one bit per screen row still to be copied to MMIO
 
 static size_t cursor_row;
 static size_t cursor_col;
@@ -19,45 +28,59 @@ static uint16_t make_vga_entry(char c, uint8_t color) {
     return (uint16_t)c | (uint16_t)color << 8;
 }
 
+static size_t ring_index(size_t screen_row, size_t back) {
+    return (g_top + VGA_HISTORY_ROWS + screen_row - back) % VGA_HISTORY_ROWS;
+}
+
+static void mark_all_dirty(void) {
+    g_dirty = (1u << VGA_HEIGHT) - 1u;
+}
+
+static void clear_row(uint16_t *row) {
+    kmemset16(row, make_vga_entry(' ', vga_color), VGA_WIDTH);
+}
+
+static void copy_row_to_screen(size_t screen_row, const uint16_t *src) {
+    kmemcpy((uint16_t *)VGA_BUFFER + screen_row * VGA_WIDTH, src, VGA_WIDTH * sizeof(uint16_t));
+}
+
+void vga_flush(void) {
+    uint32_t dirty = g_dirty;
+    g_dirty = 0;
+    for (size_t row = 0; dirty != 0; row++, dirty >>= 1) {
+        if (dirty & 1u) {
+            copy_row_to_screen(row, g_rows[ring_index(row, g_view)]);
+        }
+    }
+}
+
 static void scroll_if_needed(void) {
     if (cursor_row < VGA_HEIGHT) {
         return;
     }
 
-    for (size_t row = 1; row < VGA_HEIGHT; row++) {
-        for (size_t col = 0; col < VGA_WIDTH; col++) {
-            VGA_BUFFER[(row - 1) * VGA_WIDTH + col] = VGA_BUFFER[row * VGA_WIDTH + col];
-        }
-    }
-
-    for (size_t col = 0; col < VGA_WIDTH; col++) {
-        VGA_BUFFER[(VGA_HEIGHT - 1) * VGA_WIDTH + col] = make_vga_entry(' ', vga_color);
+    g_top = (g_top + 1) % VGA_HISTORY_ROWS;
+    if (g_scrolled < VGA_HISTORY_ROWS - VGA_HEIGHT) {
+        g_scrolled++;
     }
+    clear_row(g_rows[ring_index(VGA_HEIGHT - 1, 0)]);
+    mark_all_dirty();
 
     cursor_row = VGA_HEIGHT - 1;
 }
 
-void vga_init(void) {
-    cursor_row = 0;
-    cursor_col = 0;
-    vga_color = make_color(VGA_COLOR_LIGHT_GREY, VGA_COLOR_BLACK);
-
-    for (size_t row = 0; row < VGA_HEIGHT; row++) {
-        for (size_t col = 0; col < VGA_WIDTH; col++) {
-            VGA_BUFFER[row * VGA_WIDTH + col] = make_vga_entry(' ', vga_color);
-        }
+static void put_char(char c) {
+    if (g_view != 0) {
+        // New output snaps the display back to the live screen.
+        g_view = 0;
+        mark_all_dirty();
     }
-}
-
-void vga_set_color(vga_color_t fg, vga_color_t bg) {
-    vga_color = make_color(fg, bg);
-}
 
-void vga_putc(char c) {
     if (c == '\b') {
         if (cursor_col > 0) {
             cursor_col--;
-            VGA_BUFFER[cursor_row * VGA_WIDTH + cursor_col] = make_vga_entry(' ', vga_color);
+            g_rows[ring_index(cursor_row, 0)][cursor_col] = make_vga_entry(' ', vga_color);
+            g_dirty |= 1u << cursor_row;
         }
         return;
     }
@@ -68,7 +91,8 @@ void vga_putc(char c) {
         return;
     }
 
-    VGA_BUFFER[cursor_row * VGA_WIDTH + cursor_col] = make_vga_entry(c, vga_color);
+    g_rows[ring_index(cursor_row, 0)][cursor_col] = make_vga_entry(c, vga_color);
+    g_dirty |= 1u << cursor_row;
     cursor_col++;
     if (cursor_col >= VGA_WIDTH) {
         cursor_col = 0;
@@ -77,21 +101,75 @@ void vga_putc(char c) {
     }
 }
 
+void vga_init(void) {
+    cursor_row = 0;
+    cursor_col = 0;
+    g_top = 0;
+    g_scrolled = 0;
+    g_view = 0;
+    vga_color = make_color(VGA_COLOR_LIGHT_GREY, VGA_COLOR_BLACK);
+
+    for (size_t row = 0; row < VGA_HISTORY_ROWS; row++) {
+        clear_row(g_rows[row]);
+    }
+    mark_all_dirty();
+    vga_flush();
+}
+
+void vga_set_color(vga_color_t fg, vga_color_t bg) {
+    vga_color = make_color(fg, bg);
+}
+
+void vga_putc(char c) {
+    put_char(c);
+    vga_flush();
+}
+
 void vga_puts(const char *s) {
     if (!s) {
         return;
     }
     for (; *s; s++) {
-        vga_putc(*s);
+        put_char(*s);
+    }
+    vga_flush();
+}
+
+void vga_write(const char *s, size_t len) {
+    if (!s) {
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        put_char(s[i]);
+    }
+    vga_flush();
+}
+
+void vga_scrollback(int rows) {
+    size_t view = g_view;
+    if (rows > 0) {
+        view += (size_t)rows;
+        if (view > g_scrolled) {
+            view = g_scrolled;
+        }
+    } else {
+        size_t fwd = (size_t)-rows;
+        view = fwd >= view ? 0 : view - fwd;
+    }
+    if (view != g_view) {
+        g_view = view;
+        mark_all_dirty();
+        vga_flush();
     }
 }
 
 void vga_clear(void) {
     for (size_t row = 0; row < VGA_HEIGHT; row++) {
-        for (size_t col = 0; col < VGA_WIDTH; col++) {
-            VGA_BUFFER[row * VGA_WIDTH + col] = make_vga_entry(' ', vga_color);
-        }
+        clear_row(g_rows[ring_index(row, 0)]);
     }
+    g_view = 0;
+    mark_all_dirty();
+    vga_flush();
     cursor_row = 0;
     cursor_col = 0;
 }
@@ -0,0 +1,365 @@
+#include "services/block_service.h"
+#include "kernel/klog.h"
+#include "kernel/kmem.h"
+#include "kernel/service_registry.h"
+#include "kernel/serial.h"
+#include "kernel/trace.h"
+#include <stddef.h>
+
+// LRU block cache: entries sit on one recency list (MRU first) and, while
+// valid, on a hash chain keyed by LBA.
+#define BLOCK_CACHE_BLOCKS 128u
+#define BLOCK_HASH_BUCKETS 64u
+#define BLOCK_NIL 0xFFFFu
+
+// Sequential streams get BLOCK_READAHEAD_DEFAULT blocks prefetched past the
+// last read, BLOCK_RUN_MAX at a time.
+#define BLOCK_READAHEAD_DEFAULT 16u
+#define BLOCK_RUN_MAX 16u
+
+// Requests taken off the queue per pass; they are served in LBA order.
+#define BLOCK_BATCH_MAX IPC_QUEUE_SIZE
+
+typedef struct {
+    uint32_t lba;
+    uint16_t prev;
+    uint16_t next;
+    uint16_t hnext;
+    uint8_t valid;
+    uint8_t prefetched;
+} cache_entry_t;
+
+typedef struct {
+    msg_type_t type;
+    endpoint_id_t sender;
+    block_req_t req;
+} pending_req_t;
+
+static endpoint_id_t block_endpoint = ENDPOINT_INVALID;
+static block_dev_t *block_dev = NULL;
+
+static cache_entry_t entries[BLOCK_CACHE_BLOCKS];
+static uint8_t cache_data[BLOCK_CACHE_BLOCKS][BLOCK_SIZE] __attribute__((aligned(16)));
+static uint16_t buckets[BLOCK_HASH_BUCKETS];
+static uint16_t mru = BLOCK_NIL;
+static uint16_t lru = BLOCK_NIL;
+static uint8_t staging[BLOCK_RUN_MAX][BLOCK_SIZE] __attribute__((aligned(16)));
+
+static uint32_t readahead_blocks = BLOCK_READAHEAD_DEFAULT;
+static uint32_t seq_next = 0xFFFFFFFFu;
+static block_stats_t stats;
+
+static void copy_blocks(void *dst, const void *src, uint32_t count) {
+    kmemcpy(dst, src, count * BLOCK_SIZE);
+}
+
+static void lru_unlink(uint16_t e) {
+    if (entries[e].prev != BLOCK_NIL) {
+        entries[entries[e].prev].next = entries[e].next;
+    } else {
+        mru = entries[e].next;
+    }
+    if (entries[e].next != BLOCK_NIL) {
+        entries[entries[e].next].prev = entries[e].prev;
+    } else {
+        lru = entries[e].prev;
+    }
+}
+
+static void lru_push_front(uint16_t e) {
+    entries[e].prev = BLOCK_NIL;
+    entries[e].next = mru;
+    if (mru != BLOCK_NIL) {
+        entries[mru].prev = e;
+    }
+    mru = e;
+    if (lru == BLOCK_NIL) {
+        lru = e;
+    }
+}
+
+static void cache_touch(uint16_t e) {
+    if (mru != e) {
+        lru_unlink(e);
+        lru_push_front(e);
+    }
+}
+
+static uint16_t cache_lookup(uint32_t lba) {
+    for (uint16_t e = buckets[lba & (BLOCK_HASH_BUCKETS - 1)]; e != BLOCK_NIL; e = entries[e].hnext) {
+        if (entries[e].lba == lba) {
+            return e;
+        }
+    }
+    return BLOCK_NIL;
+}
+
+static void hash_remove(uint16_t e) {
+    uint16_t *link = &buckets[entries[e].lba & (BLOCK_HASH_BUCKETS - 1)];
+    while (*link != BLOCK_NIL) {
+        if (*link == e) {
+            *link = entries[e].hnext;
+            return;
+        }
+        link = &entries[*link].hnext;
+    }
+}
+
+// Store one block, evicting the least recently used entry if it is new.
+static void cache_insert(uint32_t lba, const void *src, int prefetched) {
+    uint16_t e = cache_lookup(lba);
+    if (e == BLOCK_NIL) {
+        e = lru;
+        if (entries[e].valid) {
+            hash_remove(e);
+        }
+        uint16_t *head = &buckets[lba & (BLOCK_HASH_BUCKETS - 1)];
+        entries[e].lba = lba;
+        entries[e].valid = 1;
+        entries[e].hnext = *head;
+        *head = e;
+    }
+    entries[e].prefetched = (uint8_t)(prefetched ? 1 : 0);
+    copy_blocks(cache_data[e], src, 1);
+    cache_touch(e);
+}
+
+static void cache_reset(void) {
+    for (uint32_t b = 0; b < BLOCK_HASH_BUCKETS; b++) {
+        buckets[b] = BLOCK_NIL;
+    }
+    mru = BLOCK_NIL;
+    lru = BLOCK_NIL;
+    for (uint16_t e = 0; e < BLOCK_CACHE_BLOCKS; e++) {
+        entries[e].valid = 0;
+        entries[e].prefetched = 0;
+        entries[e].hnext = BLOCK_NIL;
+        lru_push_front(e);
+    }
+    seq_next = 0xFFFFFFFFu;
+}
+
+// Serve [lba, lba + count) into dst: hits come from the cache, each run of
+// consecutive misses is one device read straight into dst.
+static int serve_read(uint32_t lba, uint32_t count, uint8_t *dst) {
+    uint32_t i = 0;
+    while (i < count) {
+        uint16_t e = cache_lookup(lba + i);
+        if (e != BLOCK_NIL) {
+            if (entries[e].prefetched) {
+                entries[e].prefetched = 0;
+                stats.readahead_hits++;
+            }
+            copy_blocks(dst + i * BLOCK_SIZE, cache_data[e], 1);
+            cache_touch(e);
+            stats.hits++;
+            i++;
+            continue;
+        }
+
+        uint32_t run = 1;
+        while (i + run < count && cache_lookup(lba + i + run) == BLOCK_NIL) {
+            run++;
+        }
+        stats.device_ops++;
+        if (block_dev->ops->read(block_dev, lba + i, run, dst + i * BLOCK_SIZE) != 0) {
+            return -1;
+        }
+        stats.misses += run;
+        for (uint32_t k = 0; k < run; k++) {
+            cache_insert(lba + i + k, dst + (i + k) * BLOCK_SIZE, 0);
+        }
+        i += run;
+    }
+    return 0;
+}
+
+// A read that starts where the previous one ended continues a stream: fetch
+// the next readahead_blocks that are not cached yet.
+static void readahead(uint32_t lba, uint32_t count) {
+    int sequential = (lba == seq_next);
+    seq_next = lba + count;
+    if (!sequential || readahead_blocks == 0) {
+        return;
+    }
+
+    uint32_t end = seq_next + readahead_blocks;
+    if (end > block_dev->block_count || end < seq_next) {
+        end = block_dev->block_count;
+    }
+    uint32_t next = seq_next;
+    while (next < end) {
+        if (cache_lookup(next) != BLOCK_NIL) {
+            next++;
+            continue;
+        }
+        uint32_t run = 1;
+        while (run < BLOCK_RUN_MAX && next + run < end && cache_lookup(next + run) == BLOCK_NIL) {
+            run++;
+        }
+        stats.device_ops++;
+        if (block_dev->ops->read(block_dev, next, run, staging) != 0) {
+            return;
+        }
+        for (uint32_t k = 0; k < run; k++) {
+            cache_insert(next + k, staging[k], 1);
+        }
+        stats.readahead += run;
+        next += run;
+    }
+}
+
+// Write-through: the device is updated first, then any cached copies.
+static int serve_write(uint32_t lba, uint32_t count, const uint8_t *src) {
+    stats.device_ops++;
+    if (block_dev->ops->write(block_dev, lba, count, src) != 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t e = cache_lookup(lba + i);
+        if (e != BLOCK_NIL) {
+            copy_blocks(cache_data[e], src + i * BLOCK_SIZE, 1);
+        }
+    }
+    return 0;
+}
+
+static int32_t serve(const pending_req_t *p) {
+    const block_req_t *req = &p->req;
+    if (req->count == 0 || req->count > BLOCK_REQ_MAX_BLOCKS || req->lba >= block_dev->block_count ||
+        req->count > block_dev->block_count - req->lba) {
+        return -1;
+    }
+    uint32_t bytes = req->count * BLOCK_SIZE;
+    uint32_t limit = grant_size(req->grant);
+    if (req->offset > limit || bytes > limit - req->offset) {
+        return -1;
+    }
+
+    int is_read = (p->type == MSG_BLOCK_READ);
+    uint8_t *buf = NULL;
+    if (grant_map(req->grant, block_endpoint, is_read ? GRANT_WRITE : GRANT_READ, 0, (void **)&buf) != 0) {
+        return -1;
+    }
+    int rc = is_read ? serve_read(req->lba, req->count, buf + req->offset)
+                     : serve_write(req->lba, req->count, buf + req->offset);
+    (void)grant_unmap(req->grant);
+    return rc;
+}
+
+void block_service_init(block_dev_t *dev) {
+    if (!dev || !dev->ops || dev->block_count == 0) {
+        serial_write("block_service: no disk\n");
+        return;
+    }
+
+    // Create endpoint for block service
+    block_endpoint = ipc_endpoint_create();
+    if (block_endpoint == ENDPOINT_INVALID) {
+        serial_write("block_service: failed to create endpoint\n");
+        return;
+    }
+
+    // Register service
+    if (service_register(BLOCK_SERVICE_NAME, block_endpoint) != 0) {
+        serial_write("block_service: failed to register\n");
+        return;
+    }
+
+    block_dev = dev;
+    cache_reset();
+    klog(KLOG_INFO, "block_service: %s, %u blocks (endpoint %u)", dev->name, dev->block_count, block_endpoint);
+}
+
+endpoint_id_t block_service_get_endpoint(void) {
+    return block_endpoint;
+}
+
+uint32_t block_service_block_count(void) {
+    return block_dev ? block_dev->block_count : 0;
+}
+
+void block_service_get_stats(block_stats_t *out) {
+    if (out) {
+        *out = stats;
+    }
+}
+
+void block_service_reset(void) {
+    if (block_dev) {
+        cache_reset();
+    }
+    block_stats_t zero = { 0 };
+    stats = zero;
+}
+
+uint32_t block_service_set_readahead(uint32_t blocks) {
+    uint32_t old = readahead_blocks;
+    readahead_blocks = blocks;
+    return old;
+}
+
+void block_service_process(void) {
+    if (block_endpoint == ENDPOINT_INVALID || block_dev == NULL) {
+        return;
+    }
+
+    // Take a batch off the queue and serve its reads in LBA order, so requests
+    // for neighbouring blocks reach the device as ascending runs. A write is a
+    // barrier: nothing moves across it, so every read still sees the writes
+    // queued before it and none queued after.
+    static pending_req_t batch[BLOCK_BATCH_MAX];
+    uint32_t n = 0;
+    uint32_t run = 0; // first slot reads may still be sorted into
+    ipc_msg_t msg;
+    while (n < BLOCK_BATCH_MAX && ipc_recv(block_endpoint, &msg) == IPC_SUCCESS) {
+        trace(TRACE_SVC_DISPATCH, block_endpoint, (uint32_t)msg.type);
+        if ((msg.type != MSG_BLOCK_READ && msg.type != MSG_BLOCK_WRITE) || msg.payload_len < sizeof(block_req_t)) {
+            continue;
+        }
+        pending_req_t p;
+        p.type = msg.type;
+        p.sender = msg.sender;
+        p.req = *(const block_req_t *)msg.payload;
+        uint32_t at = n++;
+        if (p.type == MSG_BLOCK_WRITE) {
+            batch[at] = p;
+            run = n;
+            continue;
+        }
+        while (at > run && batch[at - 1].req.lba > p.req.lba) {
+            batch[at] = batch[at - 1];
+            at--;
+        }
+        batch[at] = p;
+    }
+    if (n == 0) {
+        return;
+    }
+    stats.batches++;
+
+    for (uint32_t i = 0; i < n; i++) {
+        const pending_req_t *p = &batch[i];
+        int32_t status = serve(p);
+        stats.requests++;
+        if (status != 0) {
+            stats.errors++;
+        }
+
+        if (p->sender != ENDPOINT_INVALID) {
+            ipc_msg_t reply;
+            reply.type = MSG_BLOCK_REPLY;
+            reply.sender = block_endpoint;
+            reply.payload_len = sizeof(block_reply_t);
+            block_reply_t *r = (block_reply_t *)reply.payload;
+            r->tag = p->req.tag;
+            r->status = status;
+            r->count = status == 0 ? p->req.count : 0;
+            (void)ipc_send(p->sender, &reply);
+        }
+        // Prefetch after replying, so the requester is not kept waiting on it.
+        if (status == 0 && p->type == MSG_BLOCK_READ) {
+            readahead(p->req.lba, p->req.count);
+        }
+    }
+}
@@ -1,12 +1,60 @@
 #include "services/console_service.h"
+#include "kernel/grant.h"
+#include "kernel/klog.h"
+#include "kernel/kmem.h"
 #include "kernel/service_registry.h"
 #include "kernel/vga.h"
+#include "services/monitor_service.h"
 #include "kernel/serial.h"
-#include "kernel/util.h"
+#include "kernel/trace.h"
 #include <stddef.h>
 
+#define CONSOLE_OUT_BUF_SIZE 1024
+
+// klog records rendered per pass, and the backlog above which the console
+// sheds load: DEBUG is dropped, INFO is sampled 1 in CONSOLE_INFO_SAMPLE.
+#define CONSOLE_KLOG_BUDGET 32u
+#define CONSOLE_KLOG_SHED_BACKLOG 64u
+#define CONSOLE_INFO_SAMPLE 4u
+
 static endpoint_id_t console_endpoint = ENDPOINT_INVALID;
 
+// Output of one processing pass is gathered here and written with a single
+// vga_write/serial_write_len; static so it does not weigh on the task stack.
+static char out_buf[CONSOLE_OUT_BUF_SIZE];
+static size_t out_len = 0;
+static int coalesce = 1;
+
+static void console_flush(void) {
+    if (out_len == 0) {
+        return;
+    }
+    vga_write(out_buf, out_len);
+    serial_write_len(out_buf, out_len);
+    out_len = 0;
+}
+
+static void console_emit(const char *s, size_t len) {
+    if (out_len + len > CONSOLE_OUT_BUF_SIZE) {
+        console_flush();
+    }
+    if (len > CONSOLE_OUT_BUF_SIZE) {
+        vga_write(s, len);
+        serial_write_len(s, len);
+        return;
+    }
+    kmemcpy(out_buf + out_len, s, len);
+    out_len += len;
+    if (!coalesce) {
+        console_flush();
+    }
+}
+
+void console_service_set_coalesce(int enabled) {
+    console_flush();
+    coalesce = enabled ? 1 : 0;
+}
+
 void console_service_init(void) {
     // Create endpoint for console service
     console_endpoint = ipc_endpoint_create();
@@ -22,44 +70,122 @@ void console_service_init(void) {
         return;
     }
     
-    serial_write("console_service: initialized (endpoint ");
-    char buf[16];
-    uint_to_str(console_endpoint, buf, sizeof(buf));
-    serial_write(buf);
-    serial_write(")\n");
+    // Registry changes are logged, so replicas coming and going are visible.
+    (void)service_subscribe(console_endpoint);
+
+    klog(KLOG_INFO, "console_service: initialized (endpoint %u)", console_endpoint);
 }
 
 endpoint_id_t console_service_get_endpoint(void) {
     return console_endpoint;
 }
 
+static void console_grant_done(endpoint_id_t to, grant_id_t id, int32_t status) {
+    if (to == ENDPOINT_INVALID) {
+        return;
+    }
+    ipc_msg_t done;
+    done.type = MSG_GRANT_DONE;
+    done.sender = console_endpoint;
+    done.payload_len = sizeof(grant_done_t);
+    grant_done_t *d = (grant_done_t *)done.payload;
+    d->id = id;
+    d->status = status;
+    (void)ipc_send(to, &done);
+}
+
+// Print text the sender shared by grant, then hand the grant back, with a
+// failure status if it could not be used, so the sender never waits forever.
+// The region is mapped read-only, so no byte of it is copied through IPC.
+static void console_log_bulk(const ipc_msg_t *msg) {
+    if (msg->payload_len < sizeof(grant_ref_t)) {
+        console_grant_done(msg->sender, GRANT_INVALID, -1);
+        return;
+    }
+    const grant_ref_t *ref = (const grant_ref_t *)msg->payload;
+
+    const char *text = NULL;
+    if (grant_map(ref->id, console_endpoint, GRANT_READ, 0, (void **)&text) != 0) {
+        serial_write("console_service: failed to map log grant\n");
+        console_grant_done(msg->sender, ref->id, -1);
+        return;
+    }
+
+    uint32_t limit = grant_size(ref->id);
+    if (ref->offset < limit) {
+        uint32_t len = ref->length;
+        if (len > limit - ref->offset) {
+            len = limit - ref->offset;
+        }
+        console_emit("[LOG] ", 6);
+        console_emit(text + ref->offset, len);
+        if (len > 0 && text[ref->offset + len - 1] != '\n') {
+            console_emit("\n", 1);
+        }
+        // The text lives in the grant; it must be out before we unmap.
+        console_flush();
+    }
+    (void)grant_unmap(ref->id);
+    console_grant_done(msg->sender, ref->id, 0);
+}
+
+// Render pending klog records. WARN and ERROR always get through.
+static void console_drain_klog(void) {
+    static uint32_t info_seen;
+    int shedding = klog_pending() > CONSOLE_KLOG_SHED_BACKLOG;
+
+    klog_record_t rec;
+    for (uint32_t n = 0; n < CONSOLE_KLOG_BUDGET && klog_pop(&rec); n++) {
+        if (shedding && rec.level == KLOG_DEBUG) {
+            klog_note_shed();
+            continue;
+        }
+        if (shedding && rec.level == KLOG_INFO && (info_seen++ % CONSOLE_INFO_SAMPLE) != 0) {
+            klog_note_shed();
+            continue;
+        }
+        char line[128];
+        size_t len = klog_format(&rec, line, sizeof(line));
+        console_emit(line, len);
+    }
+}
+
+// Output is buffered; the next console_service_process pass flushes it.
+void console_service_handle(endpoint_id_t ep, const ipc_msg_t *msg) {
+    trace(TRACE_SVC_DISPATCH, ep, (uint32_t)msg->type);
+    if (msg->type == MSG_LOG) {
+        size_t safe_len = msg->payload_len;
+        if (safe_len >= IPC_MAX_PAYLOAD) {
+            safe_len = IPC_MAX_PAYLOAD - 1;
+        }
+
+        console_emit("[LOG] ", 6);
+        console_emit((const char *)msg->payload, safe_len);
+        if (safe_len > 0 && msg->payload[safe_len - 1] != '\n') {
+            console_emit("\n", 1);
+        }
+    } else if (msg->type == MSG_LOG_BULK) {
+        console_log_bulk(msg);
+    } else if (msg->type == MSG_SERVICE_REBOUND && msg->payload_len >= sizeof(service_rebound_t)) {
+        const service_rebound_t *ev = (const service_rebound_t *)msg->payload;
+        const char *name = service_handle_name(ev->handle);
+        klog(KLOG_DEBUG, "registry: '%s' rebound (v%u, %u instances)", name ? name : "?",
+             SERVICE_HANDLE_VERSION(ev->handle), ev->instances);
+    }
+}
+
 void console_service_process(void) {
     if (console_endpoint == ENDPOINT_INVALID) {
         return;
     }
+    static uint32_t last_beat;
+    monitor_heartbeat(console_endpoint, &last_beat);
     
-    // Process all pending messages
+    // Process all pending messages; log lines are flushed once at the end.
     ipc_msg_t msg;
     while (ipc_recv(console_endpoint, &msg) == IPC_SUCCESS) {
-        if (msg.type == MSG_LOG) {
-            // Print log message to both VGA and serial
-            vga_puts("[LOG] ");
-            serial_write("[LOG] ");
-            
-            // Ensure null termination with proper bounds checking
-            size_t safe_len = msg.payload_len;
-            if (safe_len >= IPC_MAX_PAYLOAD) {
-                safe_len = IPC_MAX_PAYLOAD - 1;
-            }
-            msg.payload[safe_len] = '\0';
-            
-            vga_puts((const char *)msg.payload);
-            serial_write((const char *)msg.payload);
-            
-            if (safe_len > 0 && msg.payload[safe_len - 1] != '\n') {
-                vga_puts("\n");
-                serial_write("\n");
-            }
-        }
+        console_service_handle(console_endpoint, &msg);
     }
+    console_drain_klog();
+    console_flush();
 }
@@ -1,10 +1,16 @@
 #include "services/echo_service.h"
+#include "kernel/klog.h"
+#include "kernel/kmem.h"
 #include "kernel/service_registry.h"
 #include "kernel/serial.h"
-#include "kernel/util.h"
+#include "kernel/trace.h"
 #include "kernel/panic.h"
+#include "kernel/syscall.h"
+#include "kernel/task.h"
 #include "services/monitor_service.h"
+#include "user/user_tasks.h"
 #include <stddef.h>
+#include <stdint.h>
 
 static endpoint_id_t echo_endpoint = ENDPOINT_INVALID;
 
@@ -23,11 +29,7 @@ void echo_service_init(void) {
         return;
     }
     
-    serial_write("echo_service: initialized (endpoint ");
-    char buf[16];
-    uint_to_str(echo_endpoint, buf, sizeof(buf));
-    serial_write(buf);
-    serial_write(")\n");
+    klog(KLOG_INFO, "echo_service: initialized (endpoint %u)", echo_endpoint);
 }
 
 endpoint_id_t echo_service_get_endpoint(void) {
@@ -35,36 +37,89 @@ endpoint_id_t echo_service_get_endpoint(void) {
 }
 
 void echo_service_process(void) {
-    if (echo_endpoint == ENDPOINT_INVALID) {
+    static uint32_t last_beat;
+    monitor_heartbeat(echo_endpoint, &last_beat);
+    echo_service_serve(echo_endpoint);
+}
+
+void echo_service_handle(endpoint_id_t ep, const ipc_msg_t *msg) {
+    trace(TRACE_SVC_DISPATCH, ep, (uint32_t)msg->type);
+    if (msg->type == MSG_CRASH) {
+        // Intentional crash for fault isolation demo
+        serial_write("echo_service: CRASH MESSAGE RECEIVED - simulating crash!\n");
+        monitor_report_crash(ep);
+        panic("echo_service: intentional crash for demo");
+    } else if (msg->type == MSG_HANG) {
+        for (;;) {
+            task_yield();
+        }
+    } else if (msg->type == MSG_ECHO) {
+        // Reply with echo response
+        ipc_msg_t reply;
+        reply.type = MSG_ECHO_REPLY;
+        reply.sender = ep;
+        reply.payload_len = msg->payload_len;
+
+        kmemcpy(reply.payload, msg->payload,
+                msg->payload_len < IPC_MAX_PAYLOAD ? msg->payload_len : IPC_MAX_PAYLOAD);
+
+        // Send reply back to sender
+        ipc_error_t err = ipc_send(msg->sender, &reply);
+
+        if (err != IPC_SUCCESS) {
+            klog(KLOG_WARN, "echo_service: failed to send reply to endpoint %u (error %d)", msg->sender, err);
+        }
+    }
+}
+
+void echo_service_serve(endpoint_id_t ep) {
+    if (ep == ENDPOINT_INVALID) {
         return;
     }
     
     // Process all pending messages
     ipc_msg_t msg;
-    while (ipc_recv(echo_endpoint, &msg) == IPC_SUCCESS) {
-        if (msg.type == MSG_CRASH) {
-            // Intentional crash for fault isolation demo
-            serial_write("echo_service: CRASH MESSAGE RECEIVED - simulating crash!\n");
-            monitor_report_crash(echo_endpoint);
-            panic("echo_service: intentional crash for demo");
-        } else if (msg.type == MSG_ECHO) {
-            // Reply with echo response
-            ipc_msg_t reply;
-            reply.type = MSG_ECHO_REPLY;
-            reply.sender = echo_endpoint;
-            reply.payload_len = msg.payload_len;
-            
-            // Copy payload
-            for (uint32_t i = 0; i < msg.payload_len && i < IPC_MAX_PAYLOAD; i++) {
-                reply.payload[i] = msg.payload[i];
-            }
-            
-            // Send reply back to sender
-            ipc_error_t err = ipc_send(msg.sender, &reply);
-            
-            if (err != IPC_SUCCESS) {
-                serial_write("echo_service: failed to send reply\n");
-            }
-        }
+    while (ipc_recv(ep, &msg) == IPC_SUCCESS) {
+        echo_service_handle(ep, &msg);
+    }
+}
+
+static void echo_replica_task(void *arg) {
+    endpoint_id_t ep = (endpoint_id_t)(uintptr_t)arg;
+    for (;;) {
+        echo_service_serve(ep);
+        task_yield();
+    }
+}
+
+// Same placement as the primary instance: ring 3 when SYSENTER is available.
+int echo_service_spawn_replica(endpoint_id_t *out_ep) {
+    endpoint_id_t ep = ipc_endpoint_create();
+    if (ep == ENDPOINT_INVALID) {
+        return -1;
+    }
+
+    int tid;
+    if (syscall_fast_path_available()) {
+        task_attr_t user = { .flags = TASK_FLAG_USER, .stack_size = 2048 };
+        tid = task_create_ex("echo", echo_user_main, USER_ECHO_ARG(ep, ENDPOINT_INVALID), &user);
+    } else {
+        task_attr_t isolated = { .flags = TASK_FLAG_ISOLATED, .stack_size = 2048 };
+        tid = task_create_ex("echo", echo_replica_task, (void *)(uintptr_t)ep, &isolated);
+    }
+    if (tid < 0) {
+        ipc_endpoint_destroy(ep);
+        return -1;
+    }
+    ipc_endpoint_set_owner(ep, tid);
+    if (service_register(ECHO_SERVICE_NAME, ep) != 0) {
+        (void)task_kill(tid);
+        ipc_endpoint_destroy(ep);
+        return -1;
+    }
+
+    if (out_ep) {
+        *out_ep = ep;
     }
+    return tid;
 }
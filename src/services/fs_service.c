@@ -0,0 +1,358 @@
+#include "services/fs_service.h"
+#include "kernel/klog.h"
+#include "kernel/kmem.h"
+#include "kernel/paging.h"
+#include "kernel/service_registry.h"
+#include "kernel/serial.h"
+#include "kernel/timing.h"
+#include "kernel/trace.h"
+#include "kernel/util.h"
+#include <stddef.h>
+
+// Paths are indexed once into an open-addressed table of file indices + 1.
+#define FS_HASH_SLOTS 128u
+// Read grants handed out and not yet returned with MSG_GRANT_DONE.
+#define FS_MAX_LOANS 8
+// A loan this old may be taken back when the table is full: its borrower has
+// most likely exited or restarted without returning it.
+#define FS_LOAN_TIMEOUT_NS 5000000000ull
+
+#define TAR_BLOCK 512u
+#define TAR_NAME_OFF 0
+#define TAR_NAME_LEN 100
+#define TAR_MODE_OFF 100
+#define TAR_SIZE_OFF 124
+#define TAR_TYPE_OFF 156
+#define TAR_MAGIC_OFF 257
+#define TAR_PREFIX_OFF 345
+#define TAR_PREFIX_LEN 155
+
+typedef struct {
+    char path[FS_PATH_MAX];
+    uint32_t hash;
+    const uint8_t *data;    // points into the archive
+    uint32_t size;
+    uint32_t mode;
+} fs_file_t;
+
+typedef struct {
+    grant_id_t id;          // GRANT_INVALID = free
+    endpoint_id_t borrower; // only it may return the grant
+    uint64_t lent_at;       // clock_monotonic_ns()
+} fs_loan_t;
+
+static endpoint_id_t fs_endpoint = ENDPOINT_INVALID;
+static fs_file_t files[FS_MAX_FILES];
+static uint32_t file_count = 0;
+static uint16_t slots[FS_HASH_SLOTS];
+static fs_loan_t loans[FS_MAX_LOANS];
+static const uint8_t *archive = NULL;
+static uint32_t archive_bytes = 0;
+static int indexed = 0;
+
+static int path_eq(const char *a, const char *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static uint32_t tar_octal(const uint8_t *field, uint32_t len) {
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < len && field[i] >= '0' && field[i] <= '7'; i++) {
+        v = (v << 3) | (uint32_t)(field[i] - '0');
+    }
+    return v;
+}
+
+// Append at most `max` bytes of a NUL-padded header field. Returns the new
+// length, or FS_PATH_MAX if the path does not fit.
+static uint32_t path_append(char *out, uint32_t len, const uint8_t *field, uint32_t max) {
+    for (uint32_t i = 0; i < max && field[i] != '\0'; i++) {
+        if (len + 1 >= FS_PATH_MAX) {
+            return FS_PATH_MAX;
+        }
+        out[len++] = (char)field[i];
+    }
+    out[len] = '\0';
+    return len;
+}
+
+// Absolute path of an entry: "/" + prefix + "/" + name, without "./".
+static int tar_path(const uint8_t *hdr, char *out) {
+    char raw[FS_PATH_MAX];
+    uint32_t len = 0;
+    raw[0] = '\0';
+    if (hdr[TAR_PREFIX_OFF] != '\0') {
+        len = path_append(raw, len, hdr + TAR_PREFIX_OFF, TAR_PREFIX_LEN);
+        if (len >= FS_PATH_MAX - 1) {
+            return -1;
+        }
+        raw[len++] = '/';
+    }
+    len = path_append(raw, len, hdr + TAR_NAME_OFF, TAR_NAME_LEN);
+    if (len >= FS_PATH_MAX) {
+        return -1;
+    }
+
+    const char *p = raw;
+    while (p[0] == '.' && p[1] == '/') {
+        p += 2;
+    }
+    while (*p == '/') {
+        p++;
+    }
+    if (*p == '\0') {
+        return -1;
+    }
+    uint32_t n = 0;
+    out[n++] = '/';
+    while (*p && n + 1 < FS_PATH_MAX) {
+        out[n++] = *p++;
+    }
+    out[n] = '\0';
+    return 0;
+}
+
+static void index_file(const uint8_t *hdr, const uint8_t *data, uint32_t size) {
+    if (file_count >= FS_MAX_FILES) {
+        return;
+    }
+    fs_file_t *f = &files[file_count];
+    if (tar_path(hdr, f->path) != 0) {
+        return;
+    }
+    f->hash = str_hash(f->path);
+    f->data = data;
+    f->size = size;
+    f->mode = tar_octal(hdr + TAR_MODE_OFF, 8);
+
+    uint32_t s = f->hash & (FS_HASH_SLOTS - 1);
+    while (slots[s] != 0) {
+        s = (s + 1) & (FS_HASH_SLOTS - 1);
+    }
+    slots[s] = (uint16_t)(file_count + 1);
+    file_count++;
+}
+
+// Walk ustar headers until the zero end block or anything malformed.
+static void index_archive(const uint8_t *base, uint32_t bytes) {
+    uint32_t off = 0;
+    while (off + TAR_BLOCK <= bytes) {
+        const uint8_t *hdr = base + off;
+        if (hdr[0] == '\0') {
+            break;
+        }
+        const char *magic = "ustar";
+        for (int i = 0; i < 5; i++) {
+            if (hdr[TAR_MAGIC_OFF + i] != (uint8_t)magic[i]) {
+                return;
+            }
+        }
+        uint32_t size = tar_octal(hdr + TAR_SIZE_OFF, 12);
+        uint32_t data_off = off + TAR_BLOCK;
+        if (size > bytes - data_off) {
+            return;
+        }
+        uint8_t type = hdr[TAR_TYPE_OFF];
+        if (type == '0' || type == '\0') {
+            index_file(hdr, base + data_off, size);
+        }
+        off = data_off + ((size + TAR_BLOCK - 1) & ~(TAR_BLOCK - 1));
+    }
+}
+
+static int fs_lookup(const char *path) {
+    uint32_t h = str_hash(path);
+    for (uint32_t s = h & (FS_HASH_SLOTS - 1);; s = (s + 1) & (FS_HASH_SLOTS - 1)) {
+        uint16_t v = slots[s];
+        if (v == 0) {
+            return -1;
+        }
+        const fs_file_t *f = &files[v - 1];
+        if (f->hash == h && path_eq(f->path, path)) {
+            return (int)(v - 1);
+        }
+    }
+}
+
+static void fs_reclaim(fs_loan_t *loan) {
+    (void)grant_revoke(loan->id);
+    loan->id = GRANT_INVALID;
+    loan->borrower = ENDPOINT_INVALID;
+}
+
+// A free loan slot; with none left, loans past FS_LOAN_TIMEOUT_NS are
+// taken back. Returns -1 if every loan is still recent.
+static int fs_free_loan(void) {
+    for (int i = 0; i < FS_MAX_LOANS; i++) {
+        if (loans[i].id == GRANT_INVALID) {
+            return i;
+        }
+    }
+    uint64_t now = clock_monotonic_ns();
+    int freed = -1;
+    for (int i = 0; i < FS_MAX_LOANS; i++) {
+        if (now - loans[i].lent_at >= FS_LOAN_TIMEOUT_NS) {
+            klog(KLOG_WARN, "fs_service: reclaimed grant %u from endpoint %u", loans[i].id, loans[i].borrower);
+            fs_reclaim(&loans[i]);
+            freed = i;
+        }
+    }
+    return freed;
+}
+
+// Share the archive pages holding up to `length` bytes at `offset` of a file.
+static int fs_read(const fs_read_req_t *req, endpoint_id_t client, fs_reply_t *r) {
+    if (req->fd >= file_count) {
+        return -1;
+    }
+    const fs_file_t *f = &files[req->fd];
+    r->fd = req->fd;
+    r->size = f->size;
+    r->mode = f->mode;
+    r->data.id = GRANT_INVALID;
+    r->data.offset = 0;
+    r->data.length = 0;
+    if (req->offset >= f->size || req->length == 0) {
+        return 0;
+    }
+
+    int loan = fs_free_loan();
+    if (loan < 0) {
+        return -1;
+    }
+
+    uint32_t addr = (uint32_t)(uintptr_t)(f->data + req->offset);
+    uint32_t in_page = addr & (PAGE_SIZE - 1);
+    uint32_t len = f->size - req->offset;
+    if (len > req->length) {
+        len = req->length;
+    }
+    if (len > GRANT_MAX_PAGES * PAGE_SIZE - in_page) {
+        len = GRANT_MAX_PAGES * PAGE_SIZE - in_page;
+    }
+    uint32_t npages = (in_page + len + PAGE_SIZE - 1) / PAGE_SIZE;
+    grant_id_t id = grant_create((const void *)(uintptr_t)(addr - in_page), npages, client, GRANT_READ);
+    if (id == GRANT_INVALID) {
+        return -1;
+    }
+    loans[loan].id = id;
+    loans[loan].borrower = client;
+    loans[loan].lent_at = clock_monotonic_ns();
+    r->data.id = id;
+    r->data.offset = in_page;
+    r->data.length = len;
+    return 0;
+}
+
+// Returned by someone else than the borrower: ignored, the loan stands.
+static void fs_grant_done(grant_id_t id, endpoint_id_t from) {
+    for (int i = 0; i < FS_MAX_LOANS; i++) {
+        if (loans[i].id == id && loans[i].borrower == from) {
+            fs_reclaim(&loans[i]);
+            return;
+        }
+    }
+}
+
+void fs_service_init(const void *base, uint32_t bytes) {
+    if (base == NULL) {
+        serial_write("fs_service: no archive\n");
+        return;
+    }
+
+    // Create endpoint for file service
+    fs_endpoint = ipc_endpoint_create();
+    if (fs_endpoint == ENDPOINT_INVALID) {
+        serial_write("fs_service: failed to create endpoint\n");
+        return;
+    }
+
+    // Register service
+    if (service_register(FS_SERVICE_NAME, fs_endpoint) != 0) {
+        serial_write("fs_service: failed to register\n");
+        return;
+    }
+
+    for (uint32_t s = 0; s < FS_HASH_SLOTS; s++) {
+        slots[s] = 0;
+    }
+    for (int i = 0; i < FS_MAX_LOANS; i++) {
+        loans[i].id = GRANT_INVALID;
+        loans[i].borrower = ENDPOINT_INVALID;
+    }
+    // Indexing waits for the first request (see fs_service_process).
+    file_count = 0;
+    archive = (const uint8_t *)base;
+    archive_bytes = bytes;
+    indexed = 0;
+    klog(KLOG_INFO, "fs_service: initialized (endpoint %u)", fs_endpoint);
+}
+
+endpoint_id_t fs_service_get_endpoint(void) {
+    return fs_endpoint;
+}
+
+uint32_t fs_service_file_count(void) {
+    return file_count;
+}
+
+void fs_service_process(void) {
+    if (fs_endpoint == ENDPOINT_INVALID) {
+        return;
+    }
+    if (!indexed) {
+        indexed = 1;
+        index_archive(archive, archive_bytes);
+        klog(KLOG_INFO, "fs_service: %u files indexed", file_count);
+    }
+
+    ipc_msg_t msg;
+    while (ipc_recv(fs_endpoint, &msg) == IPC_SUCCESS) {
+        trace(TRACE_SVC_DISPATCH, fs_endpoint, (uint32_t)msg.type);
+        if (msg.type == MSG_GRANT_DONE && msg.payload_len >= sizeof(grant_done_t)) {
+            fs_grant_done(((const grant_done_t *)msg.payload)->id, msg.sender);
+            continue;
+        }
+        if (msg.sender == ENDPOINT_INVALID) {
+            continue;
+        }
+
+        ipc_msg_t reply;
+        reply.type = MSG_FS_REPLY;
+        reply.sender = fs_endpoint;
+        reply.payload_len = sizeof(fs_reply_t);
+        fs_reply_t *r = (fs_reply_t *)reply.payload;
+        r->fd = 0;
+        r->size = 0;
+        r->mode = 0;
+        r->data.id = GRANT_INVALID;
+        r->data.offset = 0;
+        r->data.length = 0;
+
+        int rc = -1;
+        if (msg.type == MSG_FS_OPEN || msg.type == MSG_FS_STAT) {
+            char path[FS_PATH_MAX];
+            uint32_t len = msg.payload_len < FS_PATH_MAX - 1 ? msg.payload_len : FS_PATH_MAX - 1;
+            kmemcpy(path, msg.payload, len);
+            path[len] = '\0';
+            int fd = fs_lookup(path);
+            if (fd >= 0) {
+                r->fd = (uint32_t)fd;
+                r->size = files[fd].size;
+                r->mode = files[fd].mode;
+                rc = 0;
+            }
+        } else if (msg.type == MSG_FS_READ && msg.payload_len >= sizeof(fs_read_req_t)) {
+            rc = fs_read((const fs_read_req_t *)msg.payload, msg.sender, r);
+        } else {
+            continue;
+        }
+        r->status = rc;
+        if (ipc_send(msg.sender, &reply) != IPC_SUCCESS && r->data.id != GRANT_INVALID) {
+            fs_grant_done(r->data.id, msg.sender);
+        }
+    }
+}
@@ -1,22 +1,120 @@
 #include "services/monitor_service.h"
+#include "kernel/klog.h"
 #include "kernel/service_registry.h"
 #include "kernel/serial.h"
+#include "kernel/trace.h"
 #include "kernel/task.h"
+#include "kernel/timing.h"
 #include "kernel/util.h"
 #include <stddef.h>
 
 #define MAX_MONITORED_SERVICES 8
 
+// A service that misses its heartbeat deadline only counts as hung if it was
+// also scheduled this many times meanwhile, so a long-running neighbour (e.g. a
+// polled benchmark) starving it is not mistaken for a hang.
+#define MONITOR_HANG_MIN_RUNS 64u
+
+// Restart backoff: the first incident restarts at once, repeated ones wait
+// MONITOR_BACKOFF_BASE << (n - 2) cycles, capped; MONITOR_STABLE_CYCLES of
+// healthy running resets the count.
+#define MONITOR_BACKOFF_BASE 1000000ull
+#define MONITOR_BACKOFF_MAX_SHIFT 8u
+#define MONITOR_STABLE_CYCLES 1000000000ull
+
 typedef struct {
     int task_id;
     endpoint_id_t endpoint;
     char name[32];
     int active;
     int crashed;
+    uint64_t deadline;      // heartbeat deadline in cycles, 0 = not checked
+    uint64_t last_beat;
+    uint32_t runs_at_beat;  // task_get_runs() when the last beat arrived
+    uint32_t failures;      // incidents since the service was last stable
+    uint64_t detected_at;
+    uint64_t restart_at;    // earliest restart allowed by the backoff
+    uint64_t restarted_at;
+    int recovering;         // restarted, first heartbeat still outstanding
 } monitored_service_t;
 
 static endpoint_id_t monitor_endpoint = ENDPOINT_INVALID;
 static monitored_service_t monitored[MAX_MONITORED_SERVICES];
+static int monitor_tid = -1;
+
+// Replica autoscaling for one service name. Load is sampled once per monitor
+// pass: a backlog of at least AUTOSCALE_HIGH_DEPTH messages per instance for
+// AUTOSCALE_UP_PASSES passes in a row adds a replica; all queues empty for
+// AUTOSCALE_DOWN_PASSES passes retires the newest one.
+#define AUTOSCALE_MAX_REPLICAS 4
+#define AUTOSCALE_HIGH_DEPTH (IPC_QUEUE_SIZE / 2)
+#define AUTOSCALE_UP_PASSES 8u
+#define AUTOSCALE_DOWN_PASSES 4096u
+
+typedef struct {
+    int task_id;
+    endpoint_id_t endpoint;
+    int draining; // unregistered, waiting for its queue to empty
+} replica_t;
+
+static struct {
+    const char *name;
+    service_handle_t handle; // polled every pass, so no rehashing of name
+    monitor_spawn_fn_t spawn;
+    int max_replicas;
+    replica_t replicas[AUTOSCALE_MAX_REPLICAS];
+    int count;
+    uint32_t busy_passes;
+    uint32_t idle_passes;
+    int paused;
+} autoscale;
+
+// Recovery latencies are logged in microseconds, saturating at 32 bits.
+static uint32_t cycles_to_us32(uint64_t c) {
+    uint64_t us = u64_div_u32(clock_cycles_to_ns(c), 1000u, NULL);
+    return us > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)us;
+}
+
+// Record an incident (crash or hang) and arm the restart.
+static void monitor_detect(monitored_service_t *m, const char *what) {
+    if (m->crashed) {
+        return;
+    }
+    serial_write("[MONITOR] ");
+    serial_write(what);
+    serial_write(" DETECTED: ");
+    serial_write(m->name);
+    serial_write("\n");
+
+    uint64_t now = tsc_to_u64(tsc_now());
+    uint64_t backoff = 0;
+    if (m->failures > 0) {
+        uint32_t shift = m->failures - 1;
+        backoff = MONITOR_BACKOFF_BASE << (shift > MONITOR_BACKOFF_MAX_SHIFT ? MONITOR_BACKOFF_MAX_SHIFT : shift);
+    }
+    m->failures++;
+    m->crashed = 1;
+    m->recovering = 0;
+    m->detected_at = now;
+    m->restart_at = now + backoff;
+
+    // Do not wait for the monitor's turn in the round-robin.
+    if (monitor_tid >= 0) {
+        task_run_next(monitor_tid);
+    }
+}
+
+// Task fault hook: a monitored task died (panic or CPU exception, e.g. a
+// ring-3 service touching kernel memory).
+static int monitor_on_task_fault(int task_id) {
+    for (int i = 0; i < MAX_MONITORED_SERVICES; i++) {
+        if (monitored[i].active && monitored[i].task_id == task_id) {
+            monitor_detect(&monitored[i], "CRASH");
+            return 1;
+        }
+    }
+    return 0;
+}
 
 void monitor_service_init(void) {
     // Create endpoint for monitor service
@@ -40,12 +138,9 @@ void monitor_service_init(void) {
         monitored[i].task_id = -1;
         monitored[i].endpoint = ENDPOINT_INVALID;
     }
+    task_set_fault_hook(monitor_on_task_fault);
     
-    serial_write("monitor_service: initialized (endpoint ");
-    char buf[16];
-    uint_to_str(monitor_endpoint, buf, sizeof(buf));
-    serial_write(buf);
-    serial_write(")\n");
+    klog(KLOG_INFO, "monitor_service: initialized (endpoint %u)", monitor_endpoint);
 }
 
 endpoint_id_t monitor_service_get_endpoint(void) {
@@ -59,6 +154,9 @@ void monitor_register_service(int task_id, endpoint_id_t ep, const char *name) {
             monitored[i].endpoint = ep;
             monitored[i].active = 1;
             monitored[i].crashed = 0;
+            monitored[i].deadline = 0;
+            monitored[i].failures = 0;
+            monitored[i].recovering = 0;
             
             // Copy name
             int j = 0;
@@ -68,9 +166,7 @@ void monitor_register_service(int task_id, endpoint_id_t ep, const char *name) {
             }
             monitored[i].name[j] = '\0';
             
-            serial_write("monitor: registered service '");
-            serial_write(monitored[i].name);
-            serial_write("'\n");
+            klog(KLOG_INFO, "monitor: registered service '%s' (task %d)", monitored[i].name, task_id);
             return;
         }
     }
@@ -78,43 +174,208 @@ void monitor_register_service(int task_id, endpoint_id_t ep, const char *name) {
     serial_write("monitor: failed to register service (no slots)\n");
 }
 
+void monitor_set_heartbeat_deadline(endpoint_id_t ep, uint32_t deadline_cycles) {
+    for (int i = 0; i < MAX_MONITORED_SERVICES; i++) {
+        if (monitored[i].active && monitored[i].endpoint == ep) {
+            monitored[i].deadline = deadline_cycles;
+            monitored[i].last_beat = tsc_to_u64(tsc_now());
+            monitored[i].runs_at_beat = task_get_runs(monitored[i].task_id);
+            return;
+        }
+    }
+}
+
+void monitor_heartbeat(endpoint_id_t self, uint32_t *last_beat) {
+    uint32_t now = tsc_now().lo;
+    if (now - *last_beat < MONITOR_HEARTBEAT_INTERVAL || monitor_endpoint == ENDPOINT_INVALID) {
+        return;
+    }
+    *last_beat = now;
+
+    ipc_msg_t beat;
+    beat.type = MSG_HEARTBEAT;
+    beat.sender = self;
+    beat.payload_len = 0;
+    (void)ipc_send(monitor_endpoint, &beat); // a full queue just means a late beat
+}
+
+static void monitor_on_heartbeat(endpoint_id_t ep) {
+    for (int i = 0; i < MAX_MONITORED_SERVICES; i++) {
+        monitored_service_t *m = &monitored[i];
+        if (!m->active || m->endpoint != ep) {
+            continue;
+        }
+        m->last_beat = tsc_to_u64(tsc_now());
+        m->runs_at_beat = task_get_runs(m->task_id);
+        if (m->recovering) {
+            m->recovering = 0;
+            klog(KLOG_INFO, "monitor: '%s' recovered in %u us (detect->restart %u, restart->heartbeat %u)",
+                 m->name, cycles_to_us32(m->last_beat - m->detected_at), cycles_to_us32(m->restarted_at - m->detected_at),
+                 cycles_to_us32(m->last_beat - m->restarted_at));
+        }
+        return;
+    }
+}
+
+static void monitor_restart(monitored_service_t *m, uint64_t now) {
+    // The endpoint is left alone, so whatever was queued for the service is
+    // still there for the new instance.
+    uint32_t kept = ipc_queue_depth(m->endpoint);
+    if (task_restart(m->task_id) != 0) {
+        klog(KLOG_ERROR, "monitor: failed to restart service '%s'", m->name);
+        return;
+    }
+    m->crashed = 0;
+    m->restarted_at = now;
+    m->last_beat = now;
+    m->runs_at_beat = task_get_runs(m->task_id);
+    klog(KLOG_WARN, "monitor: restarted '%s' (incident %u, %u queued messages kept)", m->name, m->failures, kept);
+    if (m->deadline == 0) {
+        klog(KLOG_INFO, "monitor: '%s' recovered in %u us", m->name, cycles_to_us32(now - m->detected_at));
+    } else {
+        m->recovering = 1;
+    }
+}
+
+void monitor_set_autoscale(const char *name, monitor_spawn_fn_t spawn, int max_replicas) {
+    autoscale.name = name;
+    autoscale.handle = SERVICE_HANDLE_INVALID;
+    autoscale.spawn = spawn;
+    autoscale.max_replicas = max_replicas > AUTOSCALE_MAX_REPLICAS ? AUTOSCALE_MAX_REPLICAS : max_replicas;
+    autoscale.count = 0;
+    autoscale.busy_passes = 0;
+    autoscale.idle_passes = 0;
+}
+
+void monitor_set_autoscale_paused(int paused) {
+    autoscale.paused = paused;
+    autoscale.busy_passes = 0;
+}
+
+int monitor_replica_count(void) {
+    return autoscale.count;
+}
+
+static void autoscale_remove(int idx) {
+    replica_t *r = &autoscale.replicas[idx];
+    (void)task_kill(r->task_id);
+    ipc_endpoint_destroy(r->endpoint);
+    autoscale.replicas[idx] = autoscale.replicas[autoscale.count - 1];
+    autoscale.count--;
+}
+
+static void autoscale_pass(void) {
+    if (!autoscale.name || !autoscale.spawn) {
+        return;
+    }
+
+    // Reap replicas that crashed or finished draining.
+    for (int i = autoscale.count - 1; i >= 0; i--) {
+        replica_t *r = &autoscale.replicas[i];
+        task_info_t info;
+        int alive = task_get_info(r->task_id, &info) == 0 && info.running;
+        if (!alive) {
+            (void)service_unregister(autoscale.name, r->endpoint);
+            klog(KLOG_WARN, "monitor: replica of '%s' on endpoint %u died", autoscale.name, r->endpoint);
+            autoscale_remove(i);
+        } else if (r->draining && ipc_queue_depth(r->endpoint) == 0) {
+            klog(KLOG_INFO, "monitor: retired replica of '%s' (endpoint %u)", autoscale.name, r->endpoint);
+            autoscale_remove(i);
+        }
+    }
+
+    if (autoscale.handle == SERVICE_HANDLE_INVALID) {
+        autoscale.handle = service_resolve(autoscale.name);
+    }
+    int instances = service_handle_instances(autoscale.handle);
+    uint32_t depth = service_handle_queue_depth(autoscale.handle);
+    if (instances > 0 && depth >= (uint32_t)instances * AUTOSCALE_HIGH_DEPTH) {
+        autoscale.busy_passes++;
+        autoscale.idle_passes = 0;
+    } else if (depth == 0) {
+        autoscale.idle_passes++;
+        autoscale.busy_passes = 0;
+    } else {
+        autoscale.busy_passes = 0;
+        autoscale.idle_passes = 0;
+    }
+
+    // A crashed service waiting for restart still owns its (unused) task slot.
+    int restart_pending = 0;
+    for (int i = 0; i < MAX_MONITORED_SERVICES; i++) {
+        restart_pending |= monitored[i].active && monitored[i].crashed;
+    }
+
+    if (autoscale.busy_passes >= AUTOSCALE_UP_PASSES && autoscale.count < autoscale.max_replicas &&
+        !restart_pending && !autoscale.paused) {
+        autoscale.busy_passes = 0;
+        endpoint_id_t ep = ENDPOINT_INVALID;
+        int tid = autoscale.spawn(&ep);
+        if (tid >= 0) {
+            replica_t *r = &autoscale.replicas[autoscale.count++];
+            r->task_id = tid;
+            r->endpoint = ep;
+            r->draining = 0;
+            klog(KLOG_INFO, "monitor: spawned replica of '%s' (task %d, endpoint %u)", autoscale.name, tid, ep);
+        }
+    }
+
+    if (autoscale.idle_passes >= AUTOSCALE_DOWN_PASSES) {
+        autoscale.idle_passes = 0;
+        // Newest active replica stops taking lookups; it is reaped once empty.
+        for (int i = autoscale.count - 1; i >= 0; i--) {
+            replica_t *r = &autoscale.replicas[i];
+            if (!r->draining) {
+                (void)service_unregister(autoscale.name, r->endpoint);
+                r->draining = 1;
+                break;
+            }
+        }
+    }
+}
+
 void monitor_service_process(void) {
     if (monitor_endpoint == ENDPOINT_INVALID) {
         return;
     }
     
-    // Process messages (could be heartbeats, crash notifications, etc.)
+    monitor_tid = task_get_current();
+
     ipc_msg_t msg;
     while (ipc_recv(monitor_endpoint, &msg) == IPC_SUCCESS) {
-        // Handle monitoring messages here if needed
+        trace(TRACE_SVC_DISPATCH, monitor_endpoint, (uint32_t)msg.type);
+        if (msg.type == MSG_HEARTBEAT) {
+            monitor_on_heartbeat(msg.sender);
+        }
     }
-    
-    // Check for crashed services and restart them
+
+    uint64_t now = tsc_to_u64(tsc_now());
     for (int i = 0; i < MAX_MONITORED_SERVICES; i++) {
-        if (monitored[i].active && monitored[i].crashed) {
-            serial_write("[MONITOR] Restarting crashed service: ");
-            serial_write(monitored[i].name);
-            serial_write("\n");
-            
-            // Attempt to restart the task
-            if (task_restart(monitored[i].task_id) == 0) {
-                monitored[i].crashed = 0;
-                serial_write("[MONITOR] Service restarted successfully\n");
-            } else {
-                serial_write("[MONITOR] Failed to restart service\n");
-            }
+        monitored_service_t *m = &monitored[i];
+        if (!m->active) {
+            continue;
+        }
+        if (!m->crashed && m->deadline != 0 && now - m->last_beat > m->deadline &&
+            task_get_runs(m->task_id) - m->runs_at_beat >= MONITOR_HANG_MIN_RUNS) {
+            monitor_detect(m, "HANG");
+        }
+        if (m->crashed && now >= m->restart_at) {
+            monitor_restart(m, now);
+        } else if (!m->crashed && m->failures != 0 && !m->recovering &&
+                   now - m->restarted_at > MONITOR_STABLE_CYCLES) {
+            m->failures = 0;
         }
     }
+
+    autoscale_pass();
 }
 
 // Called externally when a service crash is detected
 void monitor_report_crash(endpoint_id_t crashed_ep) {
+    trace(TRACE_CRASH, crashed_ep, 0);
     for (int i = 0; i < MAX_MONITORED_SERVICES; i++) {
         if (monitored[i].active && monitored[i].endpoint == crashed_ep) {
-            serial_write("[MONITOR] CRASH DETECTED: ");
-            serial_write(monitored[i].name);
-            serial_write("\n");
-            monitored[i].crashed = 1;
+            monitor_detect(&monitored[i], "CRASH");
             return;
         }
     }
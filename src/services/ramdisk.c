@@ -0,0 +1,44 @@
+#include "services/block_dev.h"
+#include "kernel/kmem.h"
+
+#include <stddef.h>
+
+static void copy_blocks(void *dst, const void *src, uint32_t count) {
+    kmemcpy(dst, src, count * BLOCK_SIZE);
+}
+
+static int ramdisk_range_ok(const block_dev_t *dev, uint32_t lba, uint32_t count) {
+    return count != 0 && lba < dev->block_count && count <= dev->block_count - lba;
+}
+
+static int ramdisk_read(block_dev_t *dev, uint32_t lba, uint32_t count, void *buf) {
+    if (!ramdisk_range_ok(dev, lba, count)) {
+        return -1;
+    }
+    copy_blocks(buf, (const uint8_t *)dev->ctx + lba * BLOCK_SIZE, count);
+    return 0;
+}
+
+static int ramdisk_write(block_dev_t *dev, uint32_t lba, uint32_t count, const void *buf) {
+    if (!ramdisk_range_ok(dev, lba, count)) {
+        return -1;
+    }
+    copy_blocks((uint8_t *)dev->ctx + lba * BLOCK_SIZE, buf, count);
+    return 0;
+}
+
+static const block_dev_ops_t ramdisk_ops = {
+    .read = ramdisk_read,
+    .write = ramdisk_write,
+};
+
+int ramdisk_init(block_dev_t *dev, void *base, uint32_t bytes) {
+    if (!dev || !base || bytes < BLOCK_SIZE) {
+        return -1;
+    }
+    dev->name = "ramdisk";
+    dev->block_count = bytes / BLOCK_SIZE;
+    dev->ops = &ramdisk_ops;
+    dev->ctx = base;
+    return 0;
+}
@@ -1,7 +1,8 @@
 #include "services/timer_service.h"
+#include "kernel/klog.h"
 #include "kernel/service_registry.h"
 #include "kernel/serial.h"
-#include "kernel/util.h"
+#include "kernel/trace.h"
 #include <stddef.h>
 
 #define TIMER_MAX_SUBSCRIBERS 8
@@ -33,11 +34,7 @@ void timer_service_init(void) {
     subscriber_count = 0;
     tick_counter = 0;
     
-    serial_write("timer_service: initialized (endpoint ");
-    char buf[16];
-    uint_to_str(timer_endpoint, buf, sizeof(buf));
-    serial_write(buf);
-    serial_write(")\n");
+    klog(KLOG_INFO, "timer_service: initialized (endpoint %u)", timer_endpoint);
 }
 
 endpoint_id_t timer_service_get_endpoint(void) {
@@ -84,8 +81,34 @@ void timer_service_tick(void) {
             
             if (err != IPC_SUCCESS && err != IPC_ERR_QUEUE_FULL) {
                 // Ignore queue full errors (subscriber too slow)
-                serial_write("timer_service: failed to send tick\n");
+                klog(KLOG_WARN, "timer_service: failed to send tick to endpoint %u", subscribers[i]);
             }
         }
     }
 }
+
+void timer_service_handle(endpoint_id_t ep, const ipc_msg_t *msg) {
+    trace(TRACE_SVC_DISPATCH, ep, (uint32_t)msg->type);
+    if (msg->type != MSG_TIMER_TICK) {
+        return;
+    }
+    timer_service_tick();
+    if (msg->sender != ENDPOINT_INVALID) {
+        ipc_msg_t reply;
+        reply.type = MSG_TIMER_TICK;
+        reply.sender = ep;
+        reply.payload_len = sizeof(uint32_t);
+        *((uint32_t *)reply.payload) = tick_counter;
+        (void)ipc_send(msg->sender, &reply);
+    }
+}
+
+void timer_service_process(void) {
+    if (timer_endpoint == ENDPOINT_INVALID) {
+        return;
+    }
+    ipc_msg_t msg;
+    while (ipc_recv(timer_endpoint, &msg) == IPC_SUCCESS) {
+        timer_service_handle(timer_endpoint, &msg);
+    }
+}
@@ -0,0 +1,41 @@
+#include "kernel/timing.h"
+#include "user/user_tasks.h"
+#include "user/usys.h"
+
+// One-shot ring-3 task for `bench`: receives the iteration count on the
+// endpoint passed as arg, times SYS_NULL through the int 0x80 gate and
+// through SYSENTER, and replies with both TSC deltas (int lo/hi, sysenter lo/hi).
+void syscall_bench_user_main(void *arg) {
+    endpoint_id_t ep = (endpoint_id_t)(uintptr_t)arg;
+    ipc_msg_t msg;
+    usys_out_t out;
+
+    while (usys_ipc_recv(ep, &msg, &out) != IPC_SUCCESS) {
+        usys_yield();
+    }
+    uint32_t n = out.esi;
+    endpoint_id_t reply_ep = SYSCALL_HDR_SENDER(out.ebx);
+
+    tsc_t t0 = tsc_now();
+    for (uint32_t i = 0; i < n; i++) {
+        (void)usys_int(SYS_NULL, 0, 0, 0, 0);
+    }
+    tsc_t t1 = tsc_now();
+    for (uint32_t i = 0; i < n; i++) {
+        (void)usys_sysenter(SYS_NULL, 0, 0, 0, 0);
+    }
+    tsc_t t2 = tsc_now();
+
+    tsc_t d_int = tsc_sub(t1, t0);
+    tsc_t d_sysenter = tsc_sub(t2, t1);
+
+    uint32_t *words = (uint32_t *)msg.payload;
+    words[0] = d_int.lo;
+    words[1] = d_int.hi;
+    words[2] = d_sysenter.lo;
+    words[3] = d_sysenter.hi;
+    msg.type = MSG_SYSCALL_BENCH;
+    msg.sender = ep;
+    msg.payload_len = 4 * sizeof(uint32_t);
+    (void)usys_ipc_send(reply_ep, &msg);
+}
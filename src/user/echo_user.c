@@ -0,0 +1,56 @@
+#include "user/user_tasks.h"
+#include "user/usys.h"
+#include "services/monitor_service.h"
+
+static inline uint32_t user_tsc_lo(void) {
+    uint32_t lo;
+    uint32_t hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    (void)hi;
+    return lo;
+}
+
+// Ring-3 echo loop. The endpoint is created and registered by the kernel
+// (echo_service_init) and passed in, with the monitor's, as the task argument.
+void echo_user_main(void *arg) {
+    uint32_t packed = (uint32_t)(uintptr_t)arg;
+    endpoint_id_t ep = packed & 0xFFu;
+    endpoint_id_t monitor_ep = (packed >> 8) & 0xFFu;
+    ipc_msg_t msg;
+    usys_out_t out;
+    uint32_t last_beat = user_tsc_lo();
+
+    for (;;) {
+        if (monitor_ep != 0xFFu && user_tsc_lo() - last_beat >= MONITOR_HEARTBEAT_INTERVAL) {
+            last_beat = user_tsc_lo();
+            (void)usys_ipc_send_short(monitor_ep, ep, MSG_HEARTBEAT, 0, 0, 0);
+        }
+
+        if (usys_ipc_recv(ep, &msg, &out) != IPC_SUCCESS) {
+            usys_yield();
+            continue;
+        }
+
+        uint32_t type = SYSCALL_HDR_TYPE(out.ebx);
+        uint32_t len = SYSCALL_HDR_LEN(out.ebx);
+        uint32_t sender = SYSCALL_HDR_SENDER(out.ebx);
+
+        if (type == MSG_CRASH) {
+            // Stray write into the kernel image. The page is supervisor-only,
+            // so this faults and only this task dies.
+            *(volatile uint32_t *)0x00100000u = 0xDEADBEEFu;
+        } else if (type == MSG_HANG) {
+            for (;;) {
+                usys_yield();
+            }
+        } else if (type == MSG_ECHO) {
+            if (len <= SYSCALL_SHORT_MAX) {
+                (void)usys_ipc_send_short(sender, ep, MSG_ECHO_REPLY, len, out.esi, out.edi);
+            } else {
+                msg.type = MSG_ECHO_REPLY;
+                msg.sender = ep;
+                (void)usys_ipc_send(sender, &msg);
+            }
+        }
+    }
+}
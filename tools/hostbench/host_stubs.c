@@ -0,0 +1,35 @@
+// Host stand-ins for the kernel services the benchmarked modules call into.
+// Output goes to stderr so it never mixes with the harness's results.
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "kernel/klog.h"
+#include "kernel/kprintf.h"
+#include "kernel/trace.h"
+
+// Tracing stays off on the host: the benchmarks see the disabled-site cost.
+int trace_enabled;
+
+void trace_record(trace_event_t ev, uint32_t a0, uint32_t a1) {
+    (void)ev;
+    (void)a0;
+    (void)a1;
+}
+
+void klog_write(klog_level_t level, uint32_t nargs, const char *fmt, ...) {
+    (void)nargs;
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "[klog %d] ", (int)level);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+}
+
+int kprintf(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    return n;
+}
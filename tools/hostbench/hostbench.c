@@ -0,0 +1,583 @@
+// Host-native microbenchmarks for the host-portable kernel modules (ipc.c,
+// kmem.c, service_registry.c, util.c). Built and run by `make hostbench`; the binary
+// can also be run under `perf record` directly.
+//
+// Each case runs `warmup` untimed repetitions, then `reps` timed repetitions
+// of `iters` operations. Reported per operation: median, mean, stddev, min.
+//
+// `--check` (`make hostcheck`) instead compares kmem against byte loops.
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kernel/ipc.h"
+#include "kernel/kmem.h"
+#include "kernel/service_registry.h"
+#include "kernel/util.h"
+
+#define MAX_REPS 101
+#define MAX_CASES 32
+#define LINE_MAX_LEN 256
+
+typedef struct {
+    const char *name;
+    void (*setup)(void);
+    void (*run)(uint32_t iters);
+} hb_case_t;
+
+typedef struct {
+    char name[64];
+    uint32_t iters;
+    uint32_t reps;
+    double median;
+    double mean;
+    double stddev;
+    double min;
+} hb_result_t;
+
+// Results feed this so the compiler cannot drop the work.
+static volatile uint64_t g_sink;
+
+static endpoint_id_t g_ep;
+static ipc_msg_t g_msg;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// --- cases ---
+
+static void setup_ipc(void) {
+    ipc_init();
+    g_ep = ipc_endpoint_create();
+    memset(&g_msg, 0, sizeof(g_msg));
+    g_msg.type = MSG_ECHO;
+    g_msg.sender = g_ep;
+}
+
+static void run_ipc_pair(uint32_t iters, uint32_t len) {
+    ipc_msg_t out;
+    g_msg.payload_len = len;
+    for (uint32_t i = 0; i < iters; i++) {
+        (void)ipc_send(g_ep, &g_msg);
+        (void)ipc_recv(g_ep, &out);
+    }
+    g_sink += out.payload_len;
+}
+
+static void run_ipc_pair_0(uint32_t iters) {
+    run_ipc_pair(iters, 0);
+}
+
+static void run_ipc_pair_32(uint32_t iters) {
+    run_ipc_pair(iters, 32);
+}
+
+static void run_ipc_pair_64(uint32_t iters) {
+    run_ipc_pair(iters, IPC_MAX_PAYLOAD);
+}
+
+// A full queue's worth of sends, then as many receives; iters counts messages.
+static void run_ipc_fill_drain(uint32_t iters) {
+    ipc_msg_t out;
+    g_msg.payload_len = 32;
+    for (uint32_t done = 0; done < iters; done += IPC_QUEUE_SIZE) {
+        for (uint32_t i = 0; i < IPC_QUEUE_SIZE; i++) {
+            (void)ipc_send(g_ep, &g_msg);
+        }
+        for (uint32_t i = 0; i < IPC_QUEUE_SIZE; i++) {
+            (void)ipc_recv(g_ep, &out);
+        }
+    }
+    g_sink += out.payload_len;
+}
+
+static void run_ipc_send_full(uint32_t iters) {
+    for (uint32_t i = 0; i < IPC_QUEUE_SIZE; i++) {
+        (void)ipc_send(g_ep, &g_msg);
+    }
+    for (uint32_t i = 0; i < iters; i++) {
+        g_sink += (uint64_t)(int64_t)ipc_send(g_ep, &g_msg);
+    }
+}
+
+static const char *const g_names[] = {
+    "console", "echo", "timer", "monitor", "block", "fs", "log", "net",
+};
+
+static service_handle_t g_handle;
+
+static void setup_registry(uint32_t echo_instances) {
+    ipc_init();
+    service_registry_init();
+    for (uint32_t i = 0; i < sizeof(g_names) / sizeof(g_names[0]); i++) {
+        (void)service_register(g_names[i], ipc_endpoint_create());
+    }
+    for (uint32_t i = 1; i < echo_instances; i++) {
+        (void)service_register("echo", ipc_endpoint_create());
+    }
+    g_handle = SERVICE_HANDLE_INVALID;
+}
+
+static void setup_registry_1(void) {
+    setup_registry(1);
+}
+
+static void setup_registry_4(void) {
+    setup_registry(SERVICE_MAX_INSTANCES);
+}
+
+static void run_lookup(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        g_sink += service_lookup("echo");
+    }
+}
+
+static void run_lookup_hashed(uint32_t iters) {
+    uint32_t hash = service_name_hash("echo");
+    for (uint32_t i = 0; i < iters; i++) {
+        g_sink += service_lookup_hashed("echo", hash);
+    }
+}
+
+static void run_lookup_miss(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        g_sink += service_lookup("nosuchservice");
+    }
+}
+
+static void run_handle_lookup(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        g_sink += service_handle_lookup(&g_handle, "echo", NULL);
+    }
+}
+
+static void run_name_hash(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        g_sink += service_name_hash(g_names[i & 7u]);
+    }
+}
+
+static void run_uint_to_str(uint32_t iters) {
+    char buf[16];
+    for (uint32_t i = 0; i < iters; i++) {
+        g_sink += uint_to_str(i * 2654435761u, buf, sizeof(buf));
+    }
+}
+
+static void run_u32_to_hex(uint32_t iters) {
+    char buf[16];
+    for (uint32_t i = 0; i < iters; i++) {
+        g_sink += u32_to_hex(i * 2654435761u, buf, sizeof(buf));
+    }
+}
+
+static void run_u64_div(uint32_t iters) {
+    uint64_t n = 0x123456789abcdefull;
+    for (uint32_t i = 0; i < iters; i++) {
+        uint32_t rem;
+        n = u64_div_u32(n * 3u + i, 1000u + (i & 255u), &rem) + rem;
+    }
+    g_sink += n;
+}
+
+static uint8_t g_mem_src[4096];
+static uint8_t g_mem_dst[4096];
+
+static void run_kmemcpy(uint32_t iters, uint32_t len) {
+    for (uint32_t i = 0; i < iters; i++) {
+        kmemcpy(g_mem_dst, g_mem_src, len);
+    }
+    g_sink += g_mem_dst[len - 1];
+}
+
+static void run_kmemcpy_16(uint32_t iters) {
+    run_kmemcpy(iters, 16);
+}
+
+static void run_kmemcpy_64(uint32_t iters) {
+    run_kmemcpy(iters, 64);
+}
+
+static void run_kmemcpy_4096(uint32_t iters) {
+    run_kmemcpy(iters, 4096);
+}
+
+static void run_kmemset_4096(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        kmemset(g_mem_dst, (int)i, sizeof(g_mem_dst));
+    }
+    g_sink += g_mem_dst[7];
+}
+
+static void run_kmemcmp_4096(uint32_t iters) {
+    kmemcpy(g_mem_dst, g_mem_src, sizeof(g_mem_dst));
+    for (uint32_t i = 0; i < iters; i++) {
+        g_sink += (uint64_t)kmemcmp(g_mem_dst, g_mem_src, sizeof(g_mem_dst));
+    }
+}
+
+static const hb_case_t g_cases[] = {
+    { "ipc.send_recv.0", setup_ipc, run_ipc_pair_0 },
+    { "ipc.send_recv.32", setup_ipc, run_ipc_pair_32 },
+    { "ipc.send_recv.64", setup_ipc, run_ipc_pair_64 },
+    { "ipc.fill_drain.32", setup_ipc, run_ipc_fill_drain },
+    { "ipc.send_full", setup_ipc, run_ipc_send_full },
+    { "registry.lookup.1", setup_registry_1, run_lookup },
+    { "registry.lookup.4", setup_registry_4, run_lookup },
+    { "registry.lookup_hashed.1", setup_registry_1, run_lookup_hashed },
+    { "registry.lookup_miss", setup_registry_1, run_lookup_miss },
+    { "registry.handle_lookup.1", setup_registry_1, run_handle_lookup },
+    { "registry.handle_lookup.4", setup_registry_4, run_handle_lookup },
+    { "registry.name_hash", setup_registry_1, run_name_hash },
+    { "util.uint_to_str", NULL, run_uint_to_str },
+    { "util.u32_to_hex", NULL, run_u32_to_hex },
+    { "util.u64_div_u32", NULL, run_u64_div },
+    { "kmem.copy.16", NULL, run_kmemcpy_16 },
+    { "kmem.copy.64", NULL, run_kmemcpy_64 },
+    { "kmem.copy.4096", NULL, run_kmemcpy_4096 },
+    { "kmem.set.4096", NULL, run_kmemset_4096 },
+    { "kmem.cmp.4096", NULL, run_kmemcmp_4096 },
+};
+
+// --- kmem correctness ---
+
+// Sizes 0..CHECK_MAX_SIZE at every dst/src misalignment below CHECK_ALIGNS, in
+// every kmem strategy this CPU supports; GUARD bytes either side must survive.
+#define CHECK_MAX_SIZE 1024u
+#define CHECK_ALIGNS 16u
+#define CHECK_GUARD 32u
+#define CHECK_BUF (CHECK_GUARD + CHECK_ALIGNS + CHECK_MAX_SIZE + CHECK_GUARD)
+
+static uint8_t g_chk_src[CHECK_BUF] __attribute__((aligned(64)));
+static uint8_t g_chk_dst[CHECK_BUF] __attribute__((aligned(64)));
+static uint8_t g_chk_ref[CHECK_BUF] __attribute__((aligned(64)));
+static uint32_t g_chk_failures;
+
+static void chk_pattern(uint8_t *buf, uint32_t seed) {
+    for (uint32_t i = 0; i < CHECK_BUF; i++) {
+        buf[i] = (uint8_t)(i * 131u + seed);
+    }
+}
+
+static void chk_expect(int ok, const char *op, uint32_t size, uint32_t da, uint32_t sa) {
+    if (!ok && g_chk_failures++ < 10) {
+        fprintf(stderr, "check: %s impl=%s size=%u dst_align=%u src_align=%u\n", op, kmem_impl_name(kmem_impl()),
+                size, da, sa);
+    }
+}
+
+// The reference has the same guards, so one comparison covers them too.
+static int chk_same(void) {
+    for (uint32_t i = 0; i < CHECK_BUF; i++) {
+        if (g_chk_dst[i] != g_chk_ref[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void check_copy(void) {
+    chk_pattern(g_chk_src, 7);
+    for (uint32_t size = 0; size <= CHECK_MAX_SIZE; size++) {
+        for (uint32_t da = 0; da < CHECK_ALIGNS; da++) {
+            for (uint32_t sa = 0; sa < CHECK_ALIGNS; sa++) {
+                chk_pattern(g_chk_dst, 99);
+                chk_pattern(g_chk_ref, 99);
+                uint8_t *ref = g_chk_ref + CHECK_GUARD + da;
+                const uint8_t *s = g_chk_src + CHECK_GUARD + sa;
+                for (uint32_t i = 0; i < size; i++) {
+                    ref[i] = s[i];
+                }
+                kmemcpy(g_chk_dst + CHECK_GUARD + da, s, size);
+                chk_expect(chk_same(), "kmemcpy", size, da, sa);
+            }
+        }
+    }
+}
+
+static void check_set(void) {
+    for (uint32_t size = 0; size <= CHECK_MAX_SIZE; size++) {
+        for (uint32_t da = 0; da < CHECK_ALIGNS; da++) {
+            int c = (int)(0x80u + size + da); // high bit set: must be taken as unsigned char
+            chk_pattern(g_chk_dst, 3);
+            chk_pattern(g_chk_ref, 3);
+            uint8_t *ref = g_chk_ref + CHECK_GUARD + da;
+            for (uint32_t i = 0; i < size; i++) {
+                ref[i] = (uint8_t)c;
+            }
+            kmemset(g_chk_dst + CHECK_GUARD + da, c, size);
+            chk_expect(chk_same(), "kmemset", size, da, 0);
+        }
+    }
+}
+
+static void check_set16(void) {
+    for (uint32_t count = 0; count <= CHECK_MAX_SIZE / 2u; count++) {
+        for (uint32_t da = 0; da < CHECK_ALIGNS; da++) {
+            uint16_t v = (uint16_t)(0x8000u + count * 257u + da);
+            chk_pattern(g_chk_dst, 5);
+            chk_pattern(g_chk_ref, 5);
+            uint8_t *ref = g_chk_ref + CHECK_GUARD + da;
+            for (uint32_t i = 0; i < count; i++) {
+                ref[2 * i] = (uint8_t)v;
+                ref[2 * i + 1] = (uint8_t)(v >> 8);
+            }
+            kmemset16(g_chk_dst + CHECK_GUARD + da, v, count);
+            chk_expect(chk_same(), "kmemset16", count * 2u, da, 0);
+        }
+    }
+}
+
+static int byte_cmp(const uint8_t *a, const uint8_t *b, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static void check_cmp(void) {
+    for (uint32_t size = 0; size <= CHECK_MAX_SIZE; size++) {
+        for (uint32_t da = 0; da < CHECK_ALIGNS; da++) {
+            for (uint32_t sa = 0; sa < CHECK_ALIGNS; sa++) {
+                uint8_t *a = g_chk_dst + CHECK_GUARD + da;
+                uint8_t *b = g_chk_src + CHECK_GUARD + sa;
+                chk_pattern(g_chk_dst, 11);
+                for (uint32_t i = 0; i < size; i++) {
+                    b[i] = a[i];
+                }
+                chk_expect(kmemcmp(a, b, size) == 0, "kmemcmp equal", size, da, sa);
+                if (size == 0) {
+                    continue;
+                }
+                // One byte differs, both ways round, at a position that walks
+                // through every dword lane; bytes past it differ the other way.
+                uint32_t at = (size * 7u + da + sa) % size;
+                b[at] = (uint8_t)(a[at] + 1u);
+                for (uint32_t i = at + 1; i < size; i++) {
+                    b[i] = (uint8_t)(a[i] - 1u);
+                }
+                chk_expect(kmemcmp(a, b, size) == byte_cmp(a, b, size), "kmemcmp less", size, da, sa);
+                chk_expect(kmemcmp(b, a, size) == byte_cmp(b, a, size), "kmemcmp greater", size, da, sa);
+            }
+        }
+    }
+}
+
+static int run_check(void) {
+    kmem_impl_t chosen = kmem_impl();
+    uint32_t impls = 0;
+    for (kmem_impl_t impl = KMEM_IMPL_REP; impl < KMEM_IMPL_COUNT; impl++) {
+        if (kmem_set_impl(impl) != 0) {
+            continue;
+        }
+        impls++;
+        check_copy();
+        check_set();
+        check_set16();
+        check_cmp();
+    }
+    kmem_set_impl(chosen);
+    printf("kmem check: sizes 0..%u, alignments 0..%u, %u strategies: %u failure(s)\n", CHECK_MAX_SIZE,
+           CHECK_ALIGNS - 1u, impls, g_chk_failures);
+    return g_chk_failures ? 1 : 0;
+}
+
+// --- statistics ---
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void measure(const hb_case_t *c, uint32_t iters, uint32_t reps, uint32_t warmup, hb_result_t *out) {
+    double per_op[MAX_REPS];
+    if (c->setup) {
+        c->setup();
+    }
+    for (uint32_t i = 0; i < warmup; i++) {
+        c->run(iters);
+    }
+    for (uint32_t i = 0; i < reps; i++) {
+        uint64_t t0 = now_ns();
+        c->run(iters);
+        per_op[i] = (double)(now_ns() - t0) / (double)iters;
+    }
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < reps; i++) {
+        sum += per_op[i];
+    }
+    double mean = sum / reps;
+    double var = 0.0;
+    for (uint32_t i = 0; i < reps; i++) {
+        var += (per_op[i] - mean) * (per_op[i] - mean);
+    }
+    qsort(per_op, reps, sizeof(per_op[0]), cmp_double);
+
+    snprintf(out->name, sizeof(out->name), "%s", c->name);
+    out->iters = iters;
+    out->reps = reps;
+    out->median = (reps & 1u) ? per_op[reps / 2] : (per_op[reps / 2 - 1] + per_op[reps / 2]) / 2.0;
+    out->mean = mean;
+    out->stddev = reps > 1 ? sqrt(var / (reps - 1)) : 0.0;
+    out->min = per_op[0];
+}
+
+// --- CSV ---
+
+#define CSV_HEADER "name,iters,reps,median_ns,mean_ns,stddev_ns,min_ns"
+
+static int write_csv(const char *path, const hb_result_t *r, uint32_t n) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "%s\n", CSV_HEADER);
+    for (uint32_t i = 0; i < n; i++) {
+        fprintf(f, "%s,%u,%u,%.3f,%.3f,%.3f,%.3f\n", r[i].name, r[i].iters, r[i].reps, r[i].median, r[i].mean,
+                r[i].stddev, r[i].min);
+    }
+    fclose(f);
+    return 0;
+}
+
+static uint32_t read_csv(const char *path, hb_result_t *r, uint32_t max) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    char line[LINE_MAX_LEN];
+    uint32_t n = 0;
+    while (n < max && fgets(line, sizeof(line), f)) {
+        char *comma = strchr(line, ',');
+        if (!comma || strncmp(line, "name,", 5) == 0) {
+            continue;
+        }
+        *comma = '\0';
+        hb_result_t *e = &r[n];
+        snprintf(e->name, sizeof(e->name), "%.63s", line);
+        if (sscanf(comma + 1, "%u,%u,%lf,%lf,%lf,%lf", &e->iters, &e->reps, &e->median, &e->mean, &e->stddev,
+                   &e->min) == 6) {
+            n++;
+        }
+    }
+    fclose(f);
+    return n;
+}
+
+static const hb_result_t *find_result(const hb_result_t *r, uint32_t n, const char *name) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (strcmp(r[i].name, name) == 0) {
+            return &r[i];
+        }
+    }
+    return NULL;
+}
+
+// --- main ---
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--iters N] [--reps N] [--warmup N] [--filter SUBSTR]\n"
+            "          [--csv OUT] [--baseline IN] [--threshold PCT]\n"
+            "       %s --check\n",
+            argv0, argv0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t iters = 200000;
+    uint32_t reps = 15;
+    uint32_t warmup = 3;
+    double threshold = 5.0;
+    const char *filter = NULL;
+    const char *csv_out = NULL;
+    const char *baseline = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            usage(argv[0]);
+            return 0;
+        }
+        if (strcmp(arg, "--check") == 0) {
+            return run_check();
+        }
+        if (!val) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(arg, "--iters") == 0) {
+            iters = (uint32_t)strtoul(val, NULL, 0);
+        } else if (strcmp(arg, "--reps") == 0) {
+            reps = (uint32_t)strtoul(val, NULL, 0);
+        } else if (strcmp(arg, "--warmup") == 0) {
+            warmup = (uint32_t)strtoul(val, NULL, 0);
+        } else if (strcmp(arg, "--filter") == 0) {
+            filter = val;
+        } else if (strcmp(arg, "--csv") == 0) {
+            csv_out = val;
+        } else if (strcmp(arg, "--baseline") == 0) {
+            baseline = val;
+        } else if (strcmp(arg, "--threshold") == 0) {
+            threshold = strtod(val, NULL);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    if (iters == 0) {
+        iters = 1;
+    }
+    if (reps == 0 || reps > MAX_REPS) {
+        reps = reps == 0 ? 1 : MAX_REPS;
+    }
+
+    hb_result_t base[MAX_CASES];
+    uint32_t base_n = baseline ? read_csv(baseline, base, MAX_CASES) : 0;
+
+    hb_result_t results[MAX_CASES];
+    uint32_t n = 0;
+    uint32_t regressions = 0;
+    printf("%-26s %10s %10s %10s %10s", "case", "median_ns", "mean_ns", "stddev", "min_ns");
+    printf(base_n ? " %10s %8s\n" : "\n", "base_ns", "delta");
+    for (uint32_t i = 0; i < sizeof(g_cases) / sizeof(g_cases[0]); i++) {
+        if (filter && !strstr(g_cases[i].name, filter)) {
+            continue;
+        }
+        hb_result_t *r = &results[n++];
+        measure(&g_cases[i], iters, reps, warmup, r);
+        printf("%-26s %10.2f %10.2f %10.2f %10.2f", r->name, r->median, r->mean, r->stddev, r->min);
+
+        const hb_result_t *b = base_n ? find_result(base, base_n, r->name) : NULL;
+        if (b && b->median > 0.0) {
+            double delta = (r->median - b->median) * 100.0 / b->median;
+            int slower = delta > threshold;
+            regressions += (uint32_t)slower;
+            printf(" %10.2f %+7.1f%%%s", b->median, delta, slower ? "  REGRESSION" : "");
+        }
+        printf("\n");
+    }
+
+    if (csv_out && write_csv(csv_out, results, n) != 0) {
+        return 1;
+    }
+    if (base_n) {
+        printf("%u case(s) more than %.1f%% slower than %s\n", regressions, threshold, baseline);
+    }
+    return regressions ? 1 : 0;
+}